@@ -0,0 +1,392 @@
+#include <opencv2/core.hpp>      // Include for core functionalities and data structures
+#include <opencv2/imgproc.hpp>   // Include for Canny and HoughLinesP
+#include <opencv2/objdetect.hpp> // Include for CascadeClassifier and HOGDescriptor
+#include <opencv2/videoio.hpp>   // Include for reading the labelled clips
+#include <iostream>              // Include for standard input/output operations
+#include <fstream>               // Include for reading the label files
+#include <sstream>               // Include for splitting the label lines
+#include <iomanip>               // Include for formatting the result table
+#include <algorithm>             // Include for sorting the candidates
+#include <functional>            // Include for the per-stage evaluation callbacks
+#include <cstdlib>               // Include for parsing numeric arguments
+
+#include "tuning_config.hpp"     // Config file loaded by the programs at startup
+#include "lane_front_end.hpp"    // Lane front end of project/main.cpp
+#include "lane_scoring.hpp"      // Lane scoring shared with the scene benchmark
+
+using namespace cv;   // OpenCV namespace for core OpenCV functions and types
+using namespace std;  // Standard namespace for standard functions and types
+
+// One labelled object, same format as the synthetic-scene-generator ground truth
+struct Label
+{
+    string cls;   // lane, circle, blob, person, pedestrian, car, traffic_light
+    Vec4f value;  // x1,y1,x2,y2 for lanes, x,y,width,height for boxes
+};
+
+// Decoded frames of a clip and their labels
+struct Clip
+{
+    vector<Mat> frames;              // Frames held in memory so decoding is not part of the measurement
+    vector<vector<Label>> labels;    // Labels of every frame
+};
+
+// One point of a sweep
+struct Candidate
+{
+    TuningConfig config;   // Parameters of the point
+    string description;    // Human readable parameter list
+    double fps = 0;        // Frames per second of the stage
+    double precision = 0;  // Fraction of correct detections
+    double recall = 0;     // Fraction of labelled objects found
+    double f1 = 0;         // Harmonic mean of precision and recall
+    bool pareto = false;   // Not dominated in fps and f1 by any other point
+};
+
+// Detection counters accumulated over all frames of a sweep point
+struct Counts
+{
+    int truePositives = 0, detections = 0, found = 0, expected = 0;
+};
+
+// Read "frame,class,a,b,c,d" lines, the first line is a header
+static bool loadLabels(const string &path, vector<vector<Label>> &labels)
+{
+    ifstream in(path);
+    if (!in)
+        return false;
+    string line;
+    getline(in, line);  // Skip the header
+    while (getline(in, line))
+    {
+        stringstream ss(line);
+        string field;
+        vector<string> f;
+        while (getline(ss, field, ','))
+            f.push_back(field);
+        if (f.size() < 6)
+            continue;
+        int frame = atoi(f[0].c_str());
+        if (frame < 0)
+            continue;
+        if ((int)labels.size() <= frame)
+            labels.resize(frame + 1);
+        labels[frame].push_back({f[1], Vec4f((float)atof(f[2].c_str()), (float)atof(f[3].c_str()), (float)atof(f[4].c_str()), (float)atof(f[5].c_str()))});
+    }
+    return true;
+}
+
+static bool loadClip(const string &video, const string &truth, int maxFrames, Clip &clip)
+{
+    VideoCapture cap(video);
+    if (!cap.isOpened() || !loadLabels(truth, clip.labels))
+        return false;
+    Mat frame;
+    while ((int)clip.frames.size() < maxFrames && cap.read(frame))
+        clip.frames.push_back(frame.clone());
+    clip.labels.resize(clip.frames.size());
+    return !clip.frames.empty();
+}
+
+// Score Hough segments against the lane labels of a frame with the scoring of the benchmark
+static void scoreLanes(const vector<Vec4i> &lines, const vector<Label> &labels, double tolerance, Counts &c)
+{
+    vector<Vec4f> lanes;  // Lane axes of the frame
+    for (const Label &l : labels)
+        if (l.cls == "lane")
+            lanes.push_back(l.value);
+    LaneScore score = scoreLaneSegments(lines, lanes, tolerance);
+    c.truePositives += score.truePositives;
+    c.detections += score.detections;
+    c.found += score.found;
+    c.expected += score.expected;
+}
+
+// Greedy one-to-one matching of boxes against the labels of the given classes at IoU >= 0.5
+static void scoreBoxes(const vector<Rect> &boxes, const vector<Label> &labels, const vector<string> &classes, Counts &c)
+{
+    vector<Rect> truth;
+    for (const Label &l : labels)
+        if (find(classes.begin(), classes.end(), l.cls) != classes.end())
+            truth.push_back(Rect(cvRound(l.value[0]), cvRound(l.value[1]), cvRound(l.value[2]), cvRound(l.value[3])));
+    vector<bool> used(truth.size(), false);
+    c.expected += (int)truth.size();
+    c.detections += (int)boxes.size();
+    for (const Rect &b : boxes)
+    {
+        int best = -1;
+        double bestIou = 0.5;
+        for (size_t t = 0; t < truth.size(); ++t)
+        {
+            if (used[t])
+                continue;
+            double inter = (b & truth[t]).area();
+            double iou = inter / (b.area() + truth[t].area() - inter);
+            if (iou >= bestIou)
+            {
+                bestIou = iou;
+                best = (int)t;
+            }
+        }
+        if (best >= 0)
+        {
+            used[best] = true;
+            c.truePositives++;
+            c.found++;
+        }
+    }
+}
+
+// Run evaluate over every frame of every clip and fill the metrics of the candidate
+static void measure(Candidate &cand, const vector<Clip> &clips, const function<void(const Mat &, const vector<Label> &, Counts &)> &evaluate)
+{
+    Counts c;
+    int frames = 0;
+    int64 t = getTickCount();
+    for (const Clip &clip : clips)
+        for (size_t i = 0; i < clip.frames.size(); ++i, ++frames)
+            evaluate(clip.frames[i], clip.labels[i], c);
+    double seconds = (getTickCount() - t) / getTickFrequency();
+    cand.fps = seconds > 0 ? frames / seconds : 0;
+    cand.precision = c.detections ? (double)c.truePositives / c.detections : 0;
+    cand.recall = c.expected ? (double)c.found / c.expected : 0;
+    cand.f1 = (cand.precision + cand.recall) > 0 ? 2 * cand.precision * cand.recall / (cand.precision + cand.recall) : 0;
+}
+
+// Mark the points not dominated in (fps, f1) and return the chosen operating point
+static const Candidate &selectPoint(vector<Candidate> &cands, double minFps, double minF1)
+{
+    sort(cands.begin(), cands.end(), [](const Candidate &a, const Candidate &b) {
+        return a.fps != b.fps ? a.fps > b.fps : a.f1 > b.f1;
+    });
+    double bestF1 = -1;
+    for (Candidate &c : cands)  // Fastest first, a point is on the front when it beats every faster point in f1
+    {
+        c.pareto = c.f1 > bestF1;
+        bestF1 = max(bestF1, c.f1);
+    }
+
+    const Candidate *chosen = nullptr;
+    for (const Candidate &c : cands)
+    {
+        if (!c.pareto)
+            continue;
+        if (minFps > 0)  // Most accurate point that is fast enough
+        {
+            if (c.fps >= minFps && (!chosen || c.f1 > chosen->f1))
+                chosen = &c;
+        }
+        else if (minF1 > 0)  // Fastest point that is accurate enough
+        {
+            if (c.f1 >= minF1 && (!chosen || c.fps > chosen->fps))
+                chosen = &c;
+        }
+        else if (!chosen || c.f1 > chosen->f1)  // Most accurate point
+            chosen = &c;
+    }
+    if (!chosen)  // Target not reachable, fall back to the fastest point (minFps) or the most accurate one (minF1)
+    {
+        chosen = &cands.front();
+        for (const Candidate &c : cands)
+            if (minF1 > 0 && c.pareto && c.f1 > chosen->f1)
+                chosen = &c;
+    }
+    return *chosen;
+}
+
+static void printTable(const string &stage, const vector<Candidate> &cands, const Candidate &chosen)
+{
+    cout << "\n[" << stage << "] " << cands.size() << " points, '*' = Pareto front, '>' = chosen" << endl;
+    for (const Candidate &c : cands)
+        cout << (&c == &chosen ? '>' : (c.pareto ? '*' : ' ')) << " " << left << setw(44) << c.description << right << fixed
+             << setprecision(1) << " fps " << setw(7) << c.fps << setprecision(3) << "  precision " << c.precision
+             << "  recall " << c.recall << "  f1 " << c.f1 << endl;
+}
+
+int main(int argc, char *argv[])
+{
+    vector<Clip> clips;  // Labelled clips
+    vector<string> stages;  // Stages to tune
+    int maxFrames = 100;  // Frames loaded per clip
+    double minFps = 0, minF1 = 0;  // Target of the operating point
+    string configPath = "tuning.yml";  // Config file written for the programs
+    string cascadeDir = "../project/xmlfile";  // Directory of the cascades of project/main.cpp
+    vector<pair<string, string>> clipFiles;  // Video and label file of every clip
+
+    for (int i = 1; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--clip" && i + 2 < argc)
+        {
+            clipFiles.push_back({argv[i + 1], argv[i + 2]});
+            i += 2;
+        }
+        else if (arg == "--stages" && i + 1 < argc)
+        {
+            stringstream ss(argv[++i]);
+            string s;
+            while (getline(ss, s, ','))
+                stages.push_back(s);
+        }
+        else if (arg == "--max-frames" && i + 1 < argc) maxFrames = atoi(argv[++i]);
+        else if (arg == "--min-fps" && i + 1 < argc) minFps = atof(argv[++i]);
+        else if (arg == "--min-f1" && i + 1 < argc) minF1 = atof(argv[++i]);
+        else if (arg == "--config" && i + 1 < argc) configPath = argv[++i];
+        else if (arg == "--cascade-dir" && i + 1 < argc) cascadeDir = argv[++i];
+        else
+        {
+            cout << "Error: Unknown argument '" << arg << "'." << endl;
+            clipFiles.clear();
+            break;
+        }
+    }
+    if (clipFiles.empty() || stages.empty())
+    {
+        cout << "Usage: " << argv[0] << " --clip <video> <labels.csv> [--clip ...] --stages canny,hough,cascade,hog"
+             << " [--max-frames <n>] [--min-fps <fps> | --min-f1 <f1>] [--config tuning.yml] [--cascade-dir <dir>]" << endl;
+        return -1;
+    }
+
+    for (const auto &cf : clipFiles)
+    {
+        clips.emplace_back();
+        if (!loadClip(cf.first, cf.second, maxFrames, clips.back()))
+        {
+            cout << "Error: Unable to load clip " << cf.first << " / " << cf.second << endl;
+            return -1;
+        }
+        cout << "Loaded " << clips.back().frames.size() << " frames from " << cf.first << endl;
+    }
+
+    TuningConfig config;  // Existing config, only the tuned stages are replaced
+    config.load(configPath);
+
+    for (const string &stage : stages)
+    {
+        vector<Candidate> cands;
+        if (stage == "canny")  // Lane stage of project/main.cpp
+        {
+            for (double low : {50.0, 80.0, 110.0, 140.0})
+                for (double high : {120.0, 160.0, 200.0, 250.0})
+                {
+                    if (high <= low)
+                        continue;
+                    Candidate cand;
+                    cand.config = config;
+                    cand.config.cannyLow = low;
+                    cand.config.cannyHigh = high;
+                    cand.description = "canny " + to_string((int)low) + "/" + to_string((int)high);
+                    LaneBuffers buffers;
+                    vector<Vec4i> lines;
+                    measure(cand, clips, [&](const Mat &frame, const vector<Label> &labels, Counts &c) {
+                        Mat &edges = laneEdges(frame, buffers, low, high);  // Same colour mask and region of interest as the pipeline
+                        HoughLinesP(edges, lines, 1, CV_PI / 180, 50, 100, 100);  // Full resolution parameters of lineDetect
+                        scoreLanes(lines, labels, laneTolerance(frame.rows), c);
+                    });
+                    cands.push_back(cand);
+                }
+        }
+        else if (stage == "hough")  // hough-lines-detection
+        {
+            for (int div : {180, 360})
+                for (int threshold : {30, 50, 80})
+                    for (double minLen : {5.0, 20.0, 40.0})
+                        for (double gap : {2.0, 5.0, 10.0})
+                        {
+                            Candidate cand;
+                            cand.config = config;
+                            cand.config.houghThetaDivisor = div;
+                            cand.config.houghThreshold = threshold;
+                            cand.config.houghMinLineLength = minLen;
+                            cand.config.houghMaxLineGap = gap;
+                            cand.description = "hough pi/" + to_string(div) + " thr " + to_string(threshold) + " len " +
+                                               to_string((int)minLen) + " gap " + to_string((int)gap);
+                            Mat edges;
+                            vector<Vec4i> lines;
+                            measure(cand, clips, [&](const Mat &frame, const vector<Label> &labels, Counts &c) {
+                                Canny(frame, edges, 50, 200, 3);
+                                HoughLinesP(edges, lines, cand.config.houghRho, CV_PI / div, threshold, minLen, gap);
+                                scoreLanes(lines, labels, laneTolerance(frame.rows), c);
+                            });
+                            cands.push_back(cand);
+                        }
+        }
+        else if (stage == "cascade")  // Object detection of project/main.cpp
+        {
+            static const char *const files[3] = {"pedetrian1.xml", "carDetection.xml", "traffic_light2.xml"};
+            const vector<vector<string>> classes = {{"pedestrian", "person"}, {"car"}, {"traffic_light"}};
+            vector<CascadeClassifier> detectors(3);
+            for (int i = 0; i < 3; ++i)
+                if (!detectors[i].load(cascadeDir + "/" + files[i]))
+                {
+                    cout << "Error: Unable to load " << cascadeDir << "/" << files[i] << endl;
+                    return -1;
+                }
+            for (double scale : {1.05, 1.1, 1.2, 1.3})
+                for (int neighbors : {1, 2, 3, 4})
+                {
+                    Candidate cand;
+                    cand.config = config;
+                    cand.config.cascadeScaleFactor = scale;
+                    cand.config.cascadeMinNeighbors = neighbors;
+                    cand.description = "cascade scale " + to_string(scale).substr(0, 4) + " neighbors " + to_string(neighbors);
+                    vector<Rect> found;
+                    measure(cand, clips, [&](const Mat &frame, const vector<Label> &labels, Counts &c) {
+                        for (int i = 0; i < 3; ++i)
+                        {
+                            detectors[i].detectMultiScale(frame, found, scale, neighbors);
+                            scoreBoxes(found, labels, classes[i], c);
+                        }
+                    });
+                    cands.push_back(cand);
+                }
+        }
+        else if (stage == "hog")  // peopleDetect default detector
+        {
+            HOGDescriptor hog;
+            hog.setSVMDetector(HOGDescriptor::getDefaultPeopleDetector());
+            for (double scale : {1.02, 1.05, 1.1, 1.2, 1.3})
+            {
+                Candidate cand;
+                cand.config = config;
+                cand.config.hogScale = scale;
+                cand.description = "hog scale " + to_string(scale).substr(0, 4);
+                vector<Rect> found;
+                measure(cand, clips, [&](const Mat &frame, const vector<Label> &labels, Counts &c) {
+                    hog.detectMultiScale(frame, found, 0, Size(8, 8), Size(32, 32), scale, 2, false);
+                    scoreBoxes(found, labels, {"person", "pedestrian"}, c);
+                });
+                cands.push_back(cand);
+            }
+        }
+        else
+        {
+            cout << "Error: Unknown stage '" << stage << "', use canny, hough, cascade or hog." << endl;
+            return -1;
+        }
+
+        const Candidate &chosen = selectPoint(cands, minFps, minF1);
+        printTable(stage, cands, chosen);
+        if (stage == "canny")
+            config.cannyLow = chosen.config.cannyLow, config.cannyHigh = chosen.config.cannyHigh;
+        else if (stage == "hough")
+        {
+            config.houghThetaDivisor = chosen.config.houghThetaDivisor;
+            config.houghThreshold = chosen.config.houghThreshold;
+            config.houghMinLineLength = chosen.config.houghMinLineLength;
+            config.houghMaxLineGap = chosen.config.houghMaxLineGap;
+        }
+        else if (stage == "cascade")
+            config.cascadeScaleFactor = chosen.config.cascadeScaleFactor, config.cascadeMinNeighbors = chosen.config.cascadeMinNeighbors;
+        else
+            config.hogScale = chosen.config.hogScale;
+    }
+
+    if (!config.save(configPath))
+    {
+        cout << "Error: Unable to write " << configPath << endl;
+        return -1;
+    }
+    cout << "\nWrote operating point to " << configPath << endl;
+    return 0;
+}
@@ -0,0 +1,91 @@
+#ifndef CHANGE_DETECTOR_HPP
+#define CHANGE_DETECTOR_HPP
+
+#include <opencv2/core.hpp>     // Include for Mat
+#include <opencv2/imgproc.hpp>  // Include for cvtColor and resize
+#include <algorithm>            // Include for max
+
+// Front end of the video programs that decides whether a frame has to go through the full pipeline.
+// The frame is reduced to a small luma image (INTER_AREA, which also averages out sensor noise) and
+// compared block by block with the last frame that was processed: the mean absolute difference of
+// every 8x8 block of the reduced image is computed at once by an INTER_AREA resize of the
+// difference image. The frame counts as changed as soon as one block exceeds the threshold, so a
+// small moving object is not averaged away by a static background. The reference is only replaced
+// by processed frames, so a slow drift adds up until it is detected, and after maxSkip skipped
+// frames one frame is processed anyway to pick up gradual changes like lighting.
+class ChangeDetector
+{
+public:
+    // threshold <= 0 disables the detector, every frame is then reported as changed
+    explicit ChangeDetector(double threshold = 0.0, int maxSkip = 30, int width = 160)
+        : limit(threshold), maxSkip(maxSkip), width(width), run(0), processed(0), skipped(0) {}
+
+    void configure(double threshold, int maxSkipFrames)
+    {
+        limit = threshold;
+        maxSkip = maxSkipFrames;
+    }
+
+    bool enabled() const { return limit > 0.0; }
+
+    // Process the next frame regardless of the change, e.g. after the pipeline was reconfigured
+    void reset() { reference.release(); }
+
+    // True when frame has to be processed, false when the results of the previous frame still apply
+    bool changed(const cv::Mat &frame)
+    {
+        if (!enabled())
+        {
+            processed++;
+            return true;
+        }
+
+        int rows = std::max(blockSize, cvRound(frame.rows * (double)width / frame.cols));
+        cv::Size size(width - width % blockSize, rows - rows % blockSize);  // Whole number of blocks
+        cv::resize(frame, small, size, 0, 0, cv::INTER_AREA);
+        if (small.channels() == 3)
+            cv::cvtColor(small, luma, cv::COLOR_BGR2GRAY);
+        else
+            small.copyTo(luma);
+
+        bool change = reference.empty() || reference.size() != luma.size() || run >= maxSkip;
+        if (!change)
+        {
+            cv::absdiff(luma, reference, diff);
+            cv::resize(diff, blocks, cv::Size(size.width / blockSize, size.height / blockSize), 0, 0, cv::INTER_AREA);
+            double maxBlock = 0;
+            cv::minMaxLoc(blocks, nullptr, &maxBlock);
+            lastScore = maxBlock;
+            change = maxBlock > limit;
+        }
+        if (change)
+        {
+            cv::swap(reference, luma);  // The processed frame becomes the reference
+            run = 0;
+            processed++;
+        }
+        else
+        {
+            run++;
+            skipped++;
+        }
+        return change;
+    }
+
+    double score() const { return lastScore; }  // Largest block difference of the last comparison
+    long processedCount() const { return processed; }
+    long skippedCount() const { return skipped; }
+
+private:
+    static const int blockSize = 8;  // Block edge in pixels of the reduced image
+
+    double limit;            // Mean absolute luma difference of a block that counts as change
+    int maxSkip;             // Frames skipped in a row before one is processed anyway
+    int width;               // Width of the reduced image
+    int run;                 // Frames skipped since the last processed frame
+    long processed, skipped; // Frame counters for the report
+    double lastScore = 0;    // Largest block difference of the last comparison
+    cv::Mat small, luma, reference, diff, blocks;  // Buffers re-used by every frame
+};
+
+#endif // CHANGE_DETECTOR_HPP
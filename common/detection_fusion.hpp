@@ -0,0 +1,230 @@
+#ifndef DETECTION_FUSION_HPP
+#define DETECTION_FUSION_HPP
+
+#include <opencv2/core.hpp>  // Include for Rect and Size
+#include <algorithm>         // Include for nth_element, max and min
+#include <vector>            // Include for the detections, buckets and tracks
+
+// Post-processing of the raw detector output of one frame, linear in the number of boxes:
+//   1. non-maximum suppression within a class,
+//   2. class-aware overlap resolution (one region claimed by two detectors keeps the stronger box),
+//   3. frame-to-frame track IDs by IoU matching against the tracks of the previous frames.
+// Candidates are visited in score order through a counting sort over quantised scores instead of a
+// comparison sort, and every overlap test only looks at the boxes registered in the grid cells the
+// candidate covers, so dense frames with hundreds of hits do not pay for all pairs.
+
+struct Detection
+{
+    cv::Rect box;      // Box in frame pixels
+    int cls;           // Class of the detector (ResultClass for the published results)
+    float score;       // Detector confidence: neighbour count of a cascade, SVM weight of HOG
+    int trackId = -1;  // Stable ID assigned by DetectionFusion, -1 before fusion
+};
+
+static inline float boxIou(const cv::Rect &a, const cv::Rect &b)
+{
+    int inter = (a & b).area();
+    int uni = a.area() + b.area() - inter;
+    return uni > 0 ? (float)inter / uni : 0.0f;
+}
+
+// Uniform grid over the frame; every item is registered in each cell its box touches
+class GridIndex
+{
+public:
+    // Start a new frame, cellSize should be around the typical box size
+    void reset(cv::Size frame, int cellSize)
+    {
+        cell = std::max(8, cellSize);
+        cols = std::max(1, (frame.width + cell - 1) / cell);
+        rows = std::max(1, (frame.height + cell - 1) / cell);
+        if ((int)cells.size() < cols * rows)
+            cells.resize(cols * rows);
+        for (int i = 0; i < cols * rows; ++i)
+            cells[i].clear();  // Keeps the capacity for the next frame
+        stamp.clear();
+        query = 0;
+    }
+
+    void insert(int item, const cv::Rect &box)
+    {
+        if ((int)stamp.size() <= item)
+            stamp.resize(item + 1, 0);
+        forCells(box, [&](std::vector<int> &c) { c.push_back(item); });
+    }
+
+    // Call fn once for every item sharing a cell with box
+    template <typename Fn>
+    void visit(const cv::Rect &box, Fn fn)
+    {
+        query++;
+        forCells(box, [&](std::vector<int> &c) {
+            for (int item : c)
+            {
+                if (stamp[item] == query)
+                    continue;  // Already seen through another cell
+                stamp[item] = query;
+                fn(item);
+            }
+        });
+    }
+
+private:
+    int cell = 64, cols = 1, rows = 1;      // Cell edge in pixels and grid size
+    std::vector<std::vector<int>> cells;    // Items of every cell, row major
+    std::vector<unsigned> stamp;            // Last query that visited an item
+    unsigned query = 0;                     // Current query
+
+    template <typename Fn>
+    void forCells(const cv::Rect &box, Fn fn)
+    {
+        int x0 = std::min(cols - 1, std::max(0, box.x / cell)), x1 = std::min(cols - 1, std::max(0, (box.x + box.width - 1) / cell));
+        int y0 = std::min(rows - 1, std::max(0, box.y / cell)), y1 = std::min(rows - 1, std::max(0, (box.y + box.height - 1) / cell));
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x)
+                fn(cells[y * cols + x]);
+    }
+};
+
+struct FusionSettings
+{
+    float nmsIou = 0.45f;         // Same class boxes overlapping more than this are duplicates
+    float crossClassIou = 0.7f;   // Boxes of different classes overlapping more than this claim the same object
+    float trackIou = 0.3f;        // Minimum overlap of a detection with the track it continues
+    int maxTrackAge = 5;          // Frames a track survives without a detection
+    int scoreBuckets = 256;       // Resolution of the score ordering
+};
+
+// Per-stream fusion and tracking state, one instance per video stream
+class DetectionFusion
+{
+public:
+    explicit DetectionFusion(const FusionSettings &settings = FusionSettings()) : cfg(settings) {}
+
+    // Replace detections by the fused boxes with track IDs, in descending score order
+    void apply(std::vector<Detection> &detections, cv::Size frame)
+    {
+        order(detections);
+        suppress(detections, frame);
+        track(detections, frame);
+    }
+
+    // First ID handed out, lets concurrent instances over parts of one video use disjoint IDs
+    void setFirstId(int id) { nextId = id; }
+
+    int activeTracks() const { return (int)tracks.size(); }
+
+private:
+    struct Track
+    {
+        cv::Rect box;  // Box of the last detection
+        int cls;       // Class of the track
+        int id;        // Stable ID
+        int age;       // Frames since the last detection
+    };
+
+    FusionSettings cfg;
+    GridIndex grid;
+    std::vector<Detection> sorted, kept;           // Scratch lists re-used by every frame
+    std::vector<int> bucketStart;                  // Counting sort offsets
+    std::vector<int> sizes;                        // Box sizes for the median of cellSize
+    std::vector<Track> tracks, nextTracks;         // Tracks of the previous and current frame
+    std::vector<char> trackUsed;                   // Tracks already continued in this frame
+    int nextId = 0;                                // Next unused track ID
+
+    // Counting sort by quantised score, highest first. The sort is stable, so of two equal scores
+    // the detection listed first wins the overlap resolution
+    void order(std::vector<Detection> &d)
+    {
+        float maxScore = 0;
+        for (const Detection &x : d)
+            maxScore = std::max(maxScore, x.score);
+        int buckets = std::max(1, cfg.scoreBuckets);
+        auto bucketOf = [&](float s) {
+            return maxScore > 0 ? std::min(buckets - 1, std::max(0, (int)((1.0f - s / maxScore) * (buckets - 1) + 0.5f))) : 0;
+        };
+        bucketStart.assign(buckets + 1, 0);
+        for (const Detection &x : d)
+            bucketStart[bucketOf(x.score) + 1]++;
+        for (int b = 0; b < buckets; ++b)
+            bucketStart[b + 1] += bucketStart[b];
+        sorted.resize(d.size());
+        for (const Detection &x : d)
+            sorted[bucketStart[bucketOf(x.score)]++] = x;
+        d.swap(sorted);
+    }
+
+    // Grid cell size from the median box size, so a typical box touches at most four cells
+    static int cellSize(const std::vector<Detection> &d, std::vector<int> &scratch)
+    {
+        if (d.empty())
+            return 64;
+        scratch.resize(d.size());
+        for (size_t i = 0; i < d.size(); ++i)
+            scratch[i] = std::max(d[i].box.width, d[i].box.height);
+        std::nth_element(scratch.begin(), scratch.begin() + scratch.size() / 2, scratch.end());
+        return scratch[scratch.size() / 2];
+    }
+
+    // Keep a box unless a stronger kept box of its class, or of another class with a much larger
+    // overlap, already covers it
+    void suppress(std::vector<Detection> &d, cv::Size frame)
+    {
+        grid.reset(frame, cellSize(d, sizes));
+        kept.clear();
+        for (const Detection &x : d)
+        {
+            bool drop = false;
+            grid.visit(x.box, [&](int k) {
+                if (drop)
+                    return;
+                float iou = boxIou(x.box, kept[k].box);
+                drop = kept[k].cls == x.cls ? iou > cfg.nmsIou : iou > cfg.crossClassIou;
+            });
+            if (drop)
+                continue;
+            grid.insert((int)kept.size(), x.box);
+            kept.push_back(x);
+        }
+        d.swap(kept);
+    }
+
+    // Continue the best overlapping unused track of the same class, start a new one otherwise
+    void track(std::vector<Detection> &d, cv::Size frame)
+    {
+        grid.reset(frame, cellSize(d, sizes));
+        for (size_t t = 0; t < tracks.size(); ++t)
+            grid.insert((int)t, tracks[t].box);
+        trackUsed.assign(tracks.size(), 0);
+        nextTracks.clear();
+        for (Detection &x : d)  // Strongest detections choose first
+        {
+            int best = -1;
+            float bestIou = cfg.trackIou;
+            grid.visit(x.box, [&](int t) {
+                if (trackUsed[t] || tracks[t].cls != x.cls)
+                    return;
+                float iou = boxIou(x.box, tracks[t].box);
+                if (iou >= bestIou)
+                {
+                    bestIou = iou;
+                    best = t;
+                }
+            });
+            if (best >= 0)
+            {
+                trackUsed[best] = 1;
+                x.trackId = tracks[best].id;
+            }
+            else
+                x.trackId = nextId++;
+            nextTracks.push_back({x.box, x.cls, x.trackId, 0});
+        }
+        for (size_t t = 0; t < tracks.size(); ++t)  // Tracks without a detection coast for a few frames
+            if (!trackUsed[t] && tracks[t].age + 1 <= cfg.maxTrackAge)
+                nextTracks.push_back({tracks[t].box, tracks[t].cls, tracks[t].id, tracks[t].age + 1});
+        tracks.swap(nextTracks);
+    }
+};
+
+#endif // DETECTION_FUSION_HPP
@@ -0,0 +1,82 @@
+#ifndef LANE_FRONT_END_HPP
+#define LANE_FRONT_END_HPP
+
+#include <opencv2/core.hpp>     // Include for Mat and the geometric types
+#include <opencv2/imgproc.hpp>  // Include for cvtColor, inRange, fillPoly and Canny
+#include <cmath>                // Include for round
+#include <cstddef>              // Include for size_t
+
+// Edge image of the lane stage of project/main.cpp: yellow and white colour mask, trapezoid region
+// of interest in the lower part of the frame, then Canny on the masked image. auto-tuner calls the
+// same function, so the Canny thresholds it writes are chosen on the edge image the pipeline sees.
+
+// Scratch images of the front end, sized on the first frame and re-used while the size stays the same
+struct LaneBuffers
+{
+    cv::Mat hls;         // HLS conversion of the input
+    cv::Mat yellowMask;  // Yellow colour mask
+    cv::Mat whiteMask;   // White colour mask
+    cv::Mat colorMask;   // Yellow or white
+    cv::Mat roiMask;     // Region of interest polygon, only redrawn when the size changes
+    cv::Mat laneMask;    // Colour mask restricted to the region of interest
+    cv::Mat masked;      // Input with everything outside the lane mask cleared
+    cv::Mat gray;        // Grayscale input of Canny
+    cv::Mat edges;       // Canny edges
+    size_t allocations = 0;  // Number of buffer (re)allocations
+
+    // Give m the requested size and type, fresh is set when it was (re)allocated
+    cv::Mat &get(cv::Mat &m, cv::Size size, int type, bool *fresh = nullptr)
+    {
+        bool realloc = m.empty() || m.size() != size || m.type() != type;
+        if (realloc)
+        {
+            m.create(size, type);
+            allocations++;
+        }
+        if (fresh)
+            *fresh = realloc;
+        return m;
+    }
+};
+
+// Edges of the lane markings of img, written into b.edges
+static inline cv::Mat &laneEdges(const cv::Mat &img, LaneBuffers &b, double cannyLow, double cannyHigh)
+{
+    cv::Size size = img.size();
+    cv::Mat &hls = b.get(b.hls, size, CV_8UC3);
+    cv::Mat &yellow = b.get(b.yellowMask, size, CV_8UC1);
+    cv::Mat &white = b.get(b.whiteMask, size, CV_8UC1);
+    cv::Mat &color = b.get(b.colorMask, size, CV_8UC1);
+    cv::cvtColor(img, hls, cv::COLOR_RGB2HLS);                                           // Colour space of the masks
+    cv::inRange(hls, cv::Scalar(100, 0, 90), cv::Scalar(50, 255, 255), yellow);          // Yellow markings
+    cv::inRange(hls, cv::Scalar(0, 70, 0), cv::Scalar(255, 255, 255), white);            // White markings
+    cv::bitwise_or(yellow, white, color);
+
+    bool fresh = false;
+    cv::Mat &roi = b.get(b.roiMask, size, CV_8UC1, &fresh);
+    if (fresh)  // The polygon only depends on the resolution
+    {
+        int x = size.width, y = size.height;
+        cv::Point vertices[4] = {cv::Point(0, y), cv::Point(x, y), cv::Point((int)std::round(0.55 * x), (int)std::round(0.6 * y)),
+                                 cv::Point((int)std::round(0.45 * x), (int)std::round(0.6 * y))};  // Bottom edge and the horizon
+        const cv::Point *polygons[1] = {vertices};
+        int count[] = {4};
+        roi.setTo(cv::Scalar(0));
+        cv::fillPoly(roi, polygons, count, 1, cv::Scalar(255), cv::LINE_8);
+    }
+
+    // Colour mask and region of interest are combined on one channel, then applied to the image once
+    cv::Mat &lane = b.get(b.laneMask, size, CV_8UC1);
+    cv::bitwise_and(color, roi, lane);
+    cv::Mat &masked = b.get(b.masked, size, img.type());
+    masked.setTo(cv::Scalar(0, 0, 0));  // A masked copy leaves the pixels outside the mask untouched
+    img.copyTo(masked, lane);
+
+    cv::Mat &gray = b.get(b.gray, size, CV_8UC1);
+    cv::Mat &edges = b.get(b.edges, size, CV_8UC1);
+    cv::cvtColor(masked, gray, cv::COLOR_RGB2GRAY);
+    cv::Canny(gray, edges, cannyLow, cannyHigh);
+    return edges;
+}
+
+#endif // LANE_FRONT_END_HPP
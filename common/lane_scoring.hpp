@@ -0,0 +1,54 @@
+#ifndef LANE_SCORING_HPP
+#define LANE_SCORING_HPP
+
+#include <opencv2/core.hpp>  // Include for Vec4i, Vec4f and Point2f
+#include <algorithm>         // Include for max
+#include <cmath>             // Include for fabs
+#include <vector>            // Include for the segments and lanes
+
+// Scoring of Hough line segments against labelled lanes, shared by auto-tuner (which picks the
+// Canny and Hough parameters with it) and the benchmark of synthetic-scene-generator, so both
+// report the same precision and recall for the same segments.
+// A segment is correct when both end points lie within the tolerance of the infinite lane line
+// x1,y1 -> x2,y2 (precision), a lane is found when at least one segment lies on it (recall).
+
+struct LaneScore
+{
+    int truePositives = 0;  // Segments lying on a lane
+    int detections = 0;     // All segments
+    int found = 0;          // Lanes hit by at least one segment
+    int expected = 0;       // All lanes
+};
+
+// Allowed distance of a segment end point from the lane axis, in pixels
+static inline double laneTolerance(int rows)
+{
+    return std::max(3.0, rows / 100.0);
+}
+
+static inline LaneScore scoreLaneSegments(const std::vector<cv::Vec4i> &lines, const std::vector<cv::Vec4f> &lanes, double tolerance)
+{
+    LaneScore score;
+    std::vector<bool> hit(lanes.size(), false);  // Lanes that received at least one segment
+    score.expected = (int)lanes.size();
+    score.detections = (int)lines.size();
+    for (const cv::Vec4i &s : lines)
+    {
+        bool onLane = false;
+        for (size_t i = 0; i < lanes.size(); ++i)
+        {
+            cv::Point2f a(lanes[i][0], lanes[i][1]), b(lanes[i][2], lanes[i][3]);
+            double len = std::max(1e-3, cv::norm(b - a));  // Degenerate labels do not divide by zero
+            double d1 = std::fabs((b - a).cross(cv::Point2f((float)s[0], (float)s[1]) - a)) / len;
+            double d2 = std::fabs((b - a).cross(cv::Point2f((float)s[2], (float)s[3]) - a)) / len;
+            if (d1 < tolerance && d2 < tolerance)
+                onLane = hit[i] = true;
+        }
+        score.truePositives += onLane ? 1 : 0;
+    }
+    for (bool h : hit)
+        score.found += h ? 1 : 0;  // Recall is counted per lane rather than per segment
+    return score;
+}
+
+#endif // LANE_SCORING_HPP
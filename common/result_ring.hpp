@@ -0,0 +1,322 @@
+#ifndef RESULT_RING_HPP
+#define RESULT_RING_HPP
+
+#include <opencv2/core.hpp>  // Include for Mat, Rect and Vec4f
+#include <atomic>            // Include for the lock-free sequence counters
+#include <cstdint>           // Include for the fixed size record fields
+#include <cstring>           // Include for memcpy
+#include <ctime>             // Include for clock_gettime
+#include <string>            // Include for the ring name
+#include <fcntl.h>           // Include for shm_open flags
+#include <sys/mman.h>        // Include for shm_open and mmap
+#include <sys/stat.h>        // Include for fstat
+#include <unistd.h>          // Include for ftruncate and close
+
+// Structured per-frame results published by the detection programs into POSIX shared memory, so
+// downstream processes can consume lane lines, boxes and centroids without decoding video or
+// parsing images. One producer writes, any number of consumers read at their own pace.
+//
+// Layout of the shared memory object:
+//   RingHeader | RingSlot[capacity] | frame payload[capacity] (only with published frames)
+// Every slot carries a sequence number used as a seqlock: odd while the producer writes the slot,
+// 2 * position + 2 once record number `position` is complete. A consumer copies the slot and
+// checks the sequence number again, a change means the producer lapped it and the copy is dropped.
+
+static const uint32_t RESULT_RING_MAGIC = 0x52455352;  // "RESR"
+static const uint32_t RESULT_RING_VERSION = 2;  // 2: boxes carry a track ID
+static const int RESULT_MAX_BOXES = 64;  // Boxes per record, further boxes are dropped
+
+// Classes of the published boxes
+enum ResultClass : int32_t
+{
+    RESULT_PEDESTRIAN = 0,
+    RESULT_CAR = 1,
+    RESULT_TRAFFIC_LIGHT = 2,
+    RESULT_PERSON = 3,       // HOG people detector
+    RESULT_BLOB = 4          // Bright region of the moving object detector
+};
+
+static inline const char *resultClassName(int32_t c)
+{
+    static const char *const names[] = {"pedestrian", "car", "traffic_light", "person", "blob"};
+    return (c >= 0 && c <= RESULT_BLOB) ? names[c] : "unknown";
+}
+
+struct ResultBox
+{
+    int32_t cls;           // ResultClass
+    int32_t x, y, w, h;    // Bounding box in frame pixels
+    float cx, cy;          // Centroid in frame pixels
+    int32_t trackId;       // Stable ID of the object across frames, -1 when not tracked
+};
+
+struct ResultRecord
+{
+    uint64_t frameIndex;   // Index of the frame in its source
+    int64_t timestampNs;   // CLOCK_REALTIME when the record was published
+    double mediaTimeMs;    // Position of the frame in the source, -1 for live sources
+    int32_t laneCount;     // Valid entries of lanes
+    float lanes[2][4];     // x1, y1, x2, y2 of the left and right lane line
+    int32_t boxCount;      // Valid entries of boxes
+    ResultBox boxes[RESULT_MAX_BOXES];
+
+    void clear()
+    {
+        frameIndex = 0;
+        timestampNs = 0;
+        mediaTimeMs = -1.0;
+        laneCount = 0;
+        boxCount = 0;
+    }
+
+    // Append a box of class cls, returns false once the record is full
+    bool addBox(int32_t cls, const cv::Rect &r, int32_t trackId = -1)
+    {
+        return addBox(cls, r, r.x + r.width * 0.5f, r.y + r.height * 0.5f, trackId);
+    }
+
+    bool addBox(int32_t cls, const cv::Rect &r, float cx, float cy, int32_t trackId = -1)
+    {
+        if (boxCount >= RESULT_MAX_BOXES)
+            return false;
+        boxes[boxCount++] = {cls, r.x, r.y, r.width, r.height, cx, cy, trackId};
+        return true;
+    }
+
+    void addLane(const cv::Vec4f &l)
+    {
+        if (laneCount >= 2)
+            return;
+        for (int k = 0; k < 4; ++k)
+            lanes[laneCount][k] = l[k];
+        laneCount++;
+    }
+};
+
+struct RingHeader
+{
+    uint32_t magic;                 // RESULT_RING_MAGIC once the producer initialised the ring
+    uint32_t version;               // RESULT_RING_VERSION
+    uint32_t capacity;              // Number of slots
+    uint32_t frameBytes;            // Bytes of one published frame, 0 without frames
+    int32_t frameRows, frameCols, frameType;  // Geometry of the published frames
+    std::atomic<uint64_t> head;     // Number of records published so far
+};
+
+struct RingSlot
+{
+    std::atomic<uint64_t> seq;      // Seqlock of the slot, see above
+    ResultRecord record;
+};
+
+// Size of the shared memory object for a ring
+static inline size_t resultRingBytes(uint32_t capacity, uint32_t frameBytes)
+{
+    return sizeof(RingHeader) + capacity * (sizeof(RingSlot) + (size_t)frameBytes);
+}
+
+// Producer side, creates the shared memory object and publishes one record per frame
+class ResultRingWriter
+{
+public:
+    ResultRingWriter() : header(nullptr), slots(nullptr), frames(nullptr), bytes(0) {}
+    ~ResultRingWriter() { close(); }
+
+    // Create the ring "name"; frameSize empty publishes records only. A ring left by an earlier run
+    // is unlinked first instead of being truncated in place: a consumer still attached to it keeps
+    // its mapping of the old object and never sees the header or the size change under it.
+    bool open(const std::string &ringName, uint32_t capacity, cv::Size frameSize = cv::Size(), int frameType = CV_8UC3)
+    {
+        close();
+        if (capacity == 0)
+            return false;
+        uint32_t frameBytes = (uint32_t)(frameSize.area() * CV_ELEM_SIZE(frameType));
+        shm_unlink(ringName.c_str());
+        int fd = shm_open(ringName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+        if (fd < 0)
+            return false;
+        bytes = resultRingBytes(capacity, frameBytes);
+        void *base = (ftruncate(fd, (off_t)bytes) == 0) ? mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (base == MAP_FAILED)
+            return false;
+
+        name = ringName;
+        header = (RingHeader *)base;
+        slots = (RingSlot *)(header + 1);
+        frames = frameBytes ? (uint8_t *)(slots + capacity) : nullptr;
+        header->magic = 0;  // Consumers wait until the ring is initialised
+        header->version = RESULT_RING_VERSION;
+        header->capacity = capacity;
+        header->frameBytes = frameBytes;
+        header->frameRows = frameSize.height;
+        header->frameCols = frameSize.width;
+        header->frameType = frameType;
+        header->head.store(0, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < capacity; ++i)
+            slots[i].seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = RESULT_RING_MAGIC;
+        return true;
+    }
+
+    bool isOpened() const { return header != nullptr; }
+    bool publishesFrames() const { return frames != nullptr; }
+
+    // Publish a record and optionally the processed frame, never blocks
+    void publish(ResultRecord &record, const cv::Mat &frame = cv::Mat())
+    {
+        if (!header)
+            return;
+        uint64_t position = header->head.load(std::memory_order_relaxed);
+        uint32_t index = (uint32_t)(position % header->capacity);
+        RingSlot &slot = slots[index];
+
+        timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        record.timestampNs = (int64_t)now.tv_sec * 1000000000LL + now.tv_nsec;
+
+        slot.seq.store(2 * position + 1, std::memory_order_relaxed);  // Mark the slot as being written
+        std::atomic_thread_fence(std::memory_order_release);
+        memcpy(&slot.record, &record, sizeof(ResultRecord));
+        if (frames && !frame.empty() && frame.rows == header->frameRows && frame.cols == header->frameCols &&
+            frame.type() == header->frameType)
+        {
+            cv::Mat dst(frame.rows, frame.cols, frame.type(), frames + (size_t)index * header->frameBytes);
+            frame.copyTo(dst);  // Same size and type, copies into the shared memory
+        }
+        slot.seq.store(2 * position + 2, std::memory_order_release);  // Slot complete
+        header->head.store(position + 1, std::memory_order_release);
+    }
+
+    // Remove the shared memory object on a clean shutdown, consumers that still map it keep their mapping
+    void unlink()
+    {
+        if (!name.empty())
+            shm_unlink(name.c_str());
+    }
+
+    void close()
+    {
+        if (header)
+            munmap(header, bytes);
+        header = nullptr;
+        slots = nullptr;
+        frames = nullptr;
+    }
+
+private:
+    std::string name;      // Name of the shared memory object
+    RingHeader *header;    // Start of the mapping
+    RingSlot *slots;       // Record slots
+    uint8_t *frames;       // Frame payload, nullptr without frames
+    size_t bytes;          // Size of the mapping
+};
+
+// Consumer side, maps the ring read-only; every consumer keeps its own read position
+class ResultRingReader
+{
+public:
+    enum Status { READ_OK = 1, READ_PENDING = 0, READ_LAPPED = -1 };
+
+    ResultRingReader() : header(nullptr), slots(nullptr), frames(nullptr), bytes(0) {}
+    ~ResultRingReader() { close(); }
+
+    // Map an existing ring, fails when it does not exist or is not initialised yet. The object is
+    // empty between shm_open and ftruncate of the producer, and touching a mapping beyond the end of
+    // the object raises SIGBUS, so its size is checked before the header and the ring are read.
+    bool open(const std::string &ringName)
+    {
+        close();
+        int fd = shm_open(ringName.c_str(), O_RDONLY, 0);
+        if (fd < 0)
+            return false;
+        struct stat st;
+        if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(RingHeader))
+        {
+            ::close(fd);
+            return false;  // Not sized by the producer yet
+        }
+        void *base = mmap(nullptr, sizeof(RingHeader), PROT_READ, MAP_SHARED, fd, 0);  // Header first to learn the size
+        if (base == MAP_FAILED)
+        {
+            ::close(fd);
+            return false;
+        }
+        const RingHeader *h = (const RingHeader *)base;
+        bool ready = h->magic == RESULT_RING_MAGIC && h->version == RESULT_RING_VERSION;
+        size_t total = ready ? resultRingBytes(h->capacity, h->frameBytes) : 0;
+        if (ready && (size_t)st.st_size < total)
+            ready = false;  // Header of a ring that is larger than the object
+        munmap(base, sizeof(RingHeader));
+        base = ready ? mmap(nullptr, total, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (base == MAP_FAILED)
+            return false;
+
+        bytes = total;
+        header = (const RingHeader *)base;
+        slots = (const RingSlot *)(header + 1);
+        frames = header->frameBytes ? (const uint8_t *)(slots + header->capacity) : nullptr;
+        return true;
+    }
+
+    bool isOpened() const { return header != nullptr; }
+    bool hasFrames() const { return frames != nullptr; }
+    uint32_t capacity() const { return header ? header->capacity : 0; }
+
+    // Number of records published so far, positions below head - capacity are gone
+    uint64_t head() const { return header ? header->head.load(std::memory_order_acquire) : 0; }
+
+    // Copy record number position (and its frame when frame is given)
+    Status read(uint64_t position, ResultRecord &record, cv::Mat *frame = nullptr) const
+    {
+        if (!header || position >= head())
+            return READ_PENDING;
+        uint32_t index = (uint32_t)(position % header->capacity);
+        const RingSlot &slot = slots[index];
+        uint64_t expected = 2 * position + 2;
+        if (slot.seq.load(std::memory_order_acquire) != expected)
+            return READ_LAPPED;
+        memcpy(&record, &slot.record, sizeof(ResultRecord));
+        if (frame && frames)
+            cv::Mat(header->frameRows, header->frameCols, header->frameType,
+                    (void *)(frames + (size_t)index * header->frameBytes)).copyTo(*frame);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return slot.seq.load(std::memory_order_relaxed) == expected ? READ_OK : READ_LAPPED;
+    }
+
+    // Zero-copy view of the frame of record number position; the view is only valid while
+    // stillValid(position) is true, check it after the frame has been used
+    cv::Mat frameView(uint64_t position) const
+    {
+        if (!frames)
+            return cv::Mat();
+        uint32_t index = (uint32_t)(position % header->capacity);
+        return cv::Mat(header->frameRows, header->frameCols, header->frameType,
+                       (void *)(frames + (size_t)index * header->frameBytes));
+    }
+
+    bool stillValid(uint64_t position) const
+    {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        return header && slots[position % header->capacity].seq.load(std::memory_order_relaxed) == 2 * position + 2;
+    }
+
+    void close()
+    {
+        if (header)
+            munmap((void *)header, bytes);
+        header = nullptr;
+        slots = nullptr;
+        frames = nullptr;
+    }
+
+private:
+    const RingHeader *header;  // Start of the mapping
+    const RingSlot *slots;     // Record slots
+    const uint8_t *frames;     // Frame payload, nullptr without frames
+    size_t bytes;              // Size of the mapping
+};
+
+#endif // RESULT_RING_HPP
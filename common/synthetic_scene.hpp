@@ -0,0 +1,213 @@
+#ifndef SYNTHETIC_SCENE_HPP
+#define SYNTHETIC_SCENE_HPP
+
+#include <opencv2/core.hpp>      // Include for core functionalities and data structures
+#include <opencv2/imgproc.hpp>   // Include for drawing functions like line, circle and ellipse
+#include <algorithm>             // Include for std::max
+#include <cmath>                 // Include for sin/cos used by the object motion
+#include <cstdint>               // Include for the seed type
+#include <cstdio>                // Include for sscanf used by the resolution spec parser
+#include <ostream>               // Include for writing the ground truth records
+#include <string>                // Include for object labels and resolution specs
+#include <vector>                // Include for the ground truth list
+
+// One ground truth record of a rendered frame.
+// The meaning of the four values depends on the class:
+//   "lane"   -> x1, y1, x2, y2 of the lane line (bottom point first)
+//   "circle" -> cx, cy, radius, 0
+//   "blob", "person" -> x, y, width, height of the bounding box
+struct SceneObject
+{
+    std::string label;  // Class of the rendered object
+    cv::Vec4f value;    // Geometry of the object, see above
+};
+
+// Procedural frame source used in place of VideoCapture for headless load testing.
+// Renders a road with two lane lines, circles of known radii, moving bright blobs and
+// walking stick figures at any resolution and frame rate. All motion is expressed in
+// fractions of the frame size per second, so the same scene is produced at 480p and at 8K.
+class SyntheticScene
+{
+public:
+    SyntheticScene(cv::Size size = cv::Size(640, 480), double fps = 30.0, double edgeDensity = 0.2, uint64_t seed = 1)
+        : sz(size), rate(fps > 0 ? fps : 30.0), density(edgeDensity), limit(-1), index(0), rng(seed)
+    {
+        buildClutter();  // Static clutter depends only on the seed and the resolution
+    }
+
+    // Parse "<W>x<H>[@fps]" or one of the names 480p, 720p, 1080p, 4k, 8k (also with "@fps")
+    static bool parseSpec(const std::string &spec, cv::Size &size, double &fps)
+    {
+        std::string res = spec;  // Resolution part of the spec
+        size_t at = spec.find('@');  // Optional frame rate separator
+        if (at != std::string::npos)
+        {
+            res = spec.substr(0, at);  // Strip the frame rate from the resolution part
+            fps = atof(spec.c_str() + at + 1);  // Read the frame rate
+            if (fps <= 0)
+                return false;  // Frame rate must be positive
+        }
+
+        if (res == "480p") size = cv::Size(640, 480);
+        else if (res == "720p") size = cv::Size(1280, 720);
+        else if (res == "1080p") size = cv::Size(1920, 1080);
+        else if (res == "4k") size = cv::Size(3840, 2160);
+        else if (res == "8k") size = cv::Size(7680, 4320);
+        else
+        {
+            int w = 0, h = 0;  // Explicit width and height
+            if (sscanf(res.c_str(), "%dx%d", &w, &h) != 2 || w < 64 || h < 64)
+                return false;  // Reject malformed or tiny resolutions
+            size = cv::Size(w, h);
+        }
+        return true;
+    }
+
+    // Stop returning frames after n frames (negative means endless, like a camera)
+    void setFrameLimit(int n) { limit = n; }
+
+    // Render the next frame, returns false once the frame limit is reached
+    bool read(cv::Mat &frame)
+    {
+        if (limit >= 0 && index >= limit)
+        {
+            frame.release();  // Behave like VideoCapture at the end of a file
+            return false;
+        }
+        render(frame);  // Draw the scene at the current time
+        index++;  // Advance to the next frame
+        return true;
+    }
+
+    // Stream style read, mirrors "capture >> frame"
+    SyntheticScene &operator>>(cv::Mat &frame)
+    {
+        read(frame);
+        return *this;
+    }
+
+    const std::vector<SceneObject> &truth() const { return objects; }  // Ground truth of the last rendered frame
+    int frameIndex() const { return index - 1; }  // Index of the last rendered frame
+    cv::Size size() const { return sz; }
+    double fps() const { return rate; }
+
+    // Radii of the static circles, fixed by the resolution so Hough accuracy can be checked
+    std::vector<int> circleRadii() const
+    {
+        return {sz.height / 16, sz.height / 11, sz.height / 8};
+    }
+
+    // Append the ground truth of the last rendered frame as "frame,class,a,b,c,d" lines
+    void writeTruthCsv(std::ostream &out) const
+    {
+        for (const SceneObject &o : objects)
+            out << frameIndex() << "," << o.label << "," << o.value[0] << "," << o.value[1] << ","
+                << o.value[2] << "," << o.value[3] << "\n";
+    }
+
+private:
+    cv::Size sz;                   // Output resolution
+    double rate;                   // Frames per second used to derive the scene time
+    double density;                // Edge density of the background clutter (0 = clean, 1 = very busy)
+    int limit;                     // Number of frames to produce, negative for endless
+    int index;                     // Index of the next frame to render
+    cv::RNG rng;                   // Seeded generator so every run renders the same scene
+    std::vector<cv::Vec4i> clutter;  // Static clutter segments drawn on the background
+    std::vector<SceneObject> objects;  // Ground truth of the last rendered frame
+
+    // Pre-compute background clutter, the number of segments scales with the frame area
+    void buildClutter()
+    {
+        int count = (int)round(density * (double)sz.area() / 2000.0);  // About 150 segments at 480p for density 1
+        int maxLen = std::max(4, sz.width / 40);  // Short segments so they do not look like lanes
+        clutter.clear();
+        for (int i = 0; i < count; ++i)
+        {
+            int x = rng.uniform(0, sz.width);
+            int y = rng.uniform(0, sz.height);
+            clutter.push_back(cv::Vec4i(x, y, x + rng.uniform(-maxLen, maxLen), y + rng.uniform(-maxLen, maxLen)));
+        }
+    }
+
+    // Draw a stick figure inside box and return the box as ground truth
+    void drawStickFigure(cv::Mat &frame, cv::Rect box, double phase, int thickness)
+    {
+        cv::Scalar color(40, 40, 200);  // Dark red clothes so the figure stays below the blob threshold
+        int cx = box.x + box.width / 2;  // Vertical axis of the figure
+        int head = box.height / 8;  // Head radius
+        cv::Point neck(cx, box.y + 2 * head);
+        cv::Point hip(cx, box.y + box.height * 6 / 10);
+        double swing = sin(phase) * box.width * 0.4;  // Limb swing while walking
+        cv::circle(frame, cv::Point(cx, box.y + head), head, color, thickness);
+        cv::line(frame, neck, hip, color, thickness);
+        cv::line(frame, cv::Point(cx, box.y + box.height * 3 / 10), cv::Point(cx + (int)swing, box.y + box.height / 2), color, thickness);
+        cv::line(frame, cv::Point(cx, box.y + box.height * 3 / 10), cv::Point(cx - (int)swing, box.y + box.height / 2), color, thickness);
+        cv::line(frame, hip, cv::Point(cx + (int)swing, box.y + box.height), color, thickness);
+        cv::line(frame, hip, cv::Point(cx - (int)swing, box.y + box.height), color, thickness);
+        objects.push_back({"person", cv::Vec4f((float)box.x, (float)box.y, (float)box.width, (float)box.height)});
+    }
+
+    // Render the scene at time index / rate into frame
+    void render(cv::Mat &frame)
+    {
+        frame.create(sz, CV_8UC3);  // Re-uses the buffer when the caller keeps the same Mat
+        objects.clear();
+
+        double t = index / rate;  // Scene time in seconds
+        int w = sz.width, h = sz.height;
+        int thickness = std::max(1, h / 240);  // Line thickness scales with the resolution
+        int horizon = (int)round(0.6 * h);  // Matches the region of interest used by the lane detector
+
+        // Sky and asphalt
+        frame.rowRange(0, horizon).setTo(cv::Scalar(70, 50, 40));
+        frame.rowRange(horizon, h).setTo(cv::Scalar(45, 45, 45));
+
+        // Background clutter controls the edge density seen by Canny and Hough
+        for (const cv::Vec4i &c : clutter)
+            cv::line(frame, cv::Point(c[0], c[1]), cv::Point(c[2], c[3]), cv::Scalar(90, 90, 90), 1);
+
+        // Lane lines from the bottom of the frame towards the vanishing point
+        cv::Point left0((int)round(0.1 * w), h - 1), left1((int)round(0.45 * w), horizon);
+        cv::Point right0((int)round(0.9 * w), h - 1), right1((int)round(0.55 * w), horizon);
+        cv::line(frame, left0, left1, cv::Scalar(0, 200, 230), 3 * thickness);  // Yellow left lane
+        cv::line(frame, right0, right1, cv::Scalar(230, 230, 230), 3 * thickness);  // White right lane
+        objects.push_back({"lane", cv::Vec4f((float)left0.x, (float)left0.y, (float)left1.x, (float)left1.y)});
+        objects.push_back({"lane", cv::Vec4f((float)right0.x, (float)right0.y, (float)right1.x, (float)right1.y)});
+
+        // Circles of known radii drifting slowly in the sky
+        std::vector<int> radii = circleRadii();
+        for (size_t i = 0; i < radii.size(); ++i)
+        {
+            int r = radii[i];
+            double px = (i + 1) / (double)(radii.size() + 1) + 0.05 * sin(t * 0.5 + i);  // Horizontal drift
+            cv::Point c((int)round(px * w), (int)round(0.25 * h));
+            cv::circle(frame, c, r, cv::Scalar(200, 160, 60), -1, cv::LINE_AA);  // Filled disc for a strong gradient
+            objects.push_back({"circle", cv::Vec4f((float)c.x, (float)c.y, (float)r, 0.f)});
+        }
+
+        // Bright blobs moving over the road, used by the centre of mass tools
+        for (int i = 0; i < 2; ++i)
+        {
+            cv::Size axes(w / 30 + i * w / 60, h / 40 + i * h / 80);
+            double px = 0.5 + 0.3 * sin(t * (0.7 + 0.4 * i) + i);
+            double py = 0.8 + 0.1 * cos(t * (0.9 + 0.3 * i));
+            cv::Point c((int)round(px * w), (int)round(py * h));
+            cv::ellipse(frame, c, axes, 0, 0, 360, cv::Scalar(255, 255, 255), -1);
+            cv::Rect box(c.x - axes.width, c.y - axes.height, 2 * axes.width, 2 * axes.height);
+            box &= cv::Rect(0, 0, w, h);  // Clip the ground truth to the frame
+            objects.push_back({"blob", cv::Vec4f((float)box.x, (float)box.y, (float)box.width, (float)box.height)});
+        }
+
+        // Stick figures walking across the frame and wrapping around
+        for (int i = 0; i < 2; ++i)
+        {
+            int bh = h / 5, bw = bh / 2;  // Box of a standing person
+            double speed = 0.08 + 0.05 * i;  // Fraction of the width per second
+            double px = fmod(0.1 + 0.45 * i + speed * t, 1.0);
+            cv::Rect box((int)round(px * (w - bw)), horizon - bh / 2, bw, bh);
+            drawStickFigure(frame, box, t * 6.0 + i, thickness);
+        }
+    }
+};
+
+#endif // SYNTHETIC_SCENE_HPP
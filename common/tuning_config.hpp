@@ -0,0 +1,82 @@
+#ifndef TUNING_CONFIG_HPP
+#define TUNING_CONFIG_HPP
+
+#include <opencv2/core.hpp>  // Include for FileStorage
+#include <string>            // Include for the config path
+
+// Throughput-critical parameters of the programs, loaded at startup from a YAML file written by
+// auto-tuner. Every field defaults to the value the programs used before they were tunable, and
+// keys missing from the file keep their default, so a partial config only changes what it names.
+struct TuningConfig
+{
+    // project/main.cpp
+    double cascadeScaleFactor = 1.1;  // detectMultiScale scale factor
+    int cascadeMinNeighbors = 2;      // detectMultiScale minNeighbors
+    double cannyLow = 110;            // Lane stage Canny thresholds
+    double cannyHigh = 120;
+
+    // hough-lines-detection
+    double houghRho = 1;              // HoughLinesP distance resolution in pixels
+    int houghThetaDivisor = 360;      // HoughLinesP angle resolution is CV_PI / houghThetaDivisor
+    int houghThreshold = 50;          // HoughLinesP accumulator threshold
+    double houghMinLineLength = 5;    // HoughLinesP minimum segment length
+    double houghMaxLineGap = 2;       // HoughLinesP maximum gap inside a segment
+
+    // pedetrain-detection-predefined-svm
+    double hogScale = 1.05;           // HOG detectMultiScale scale
+
+    // Read the config, returns false when the file cannot be opened (the defaults stay in place)
+    bool load(const std::string &path)
+    {
+        cv::FileStorage fs;
+        try
+        {
+            if (!fs.open(path, cv::FileStorage::READ))
+                return false;
+        }
+        catch (const cv::Exception &)
+        {
+            return false;  // Malformed file
+        }
+        read(fs, "cascade_scale_factor", cascadeScaleFactor);
+        read(fs, "cascade_min_neighbors", cascadeMinNeighbors);
+        read(fs, "canny_low", cannyLow);
+        read(fs, "canny_high", cannyHigh);
+        read(fs, "hough_rho", houghRho);
+        read(fs, "hough_theta_divisor", houghThetaDivisor);
+        read(fs, "hough_threshold", houghThreshold);
+        read(fs, "hough_min_line_length", houghMinLineLength);
+        read(fs, "hough_max_line_gap", houghMaxLineGap);
+        read(fs, "hog_scale", hogScale);
+        return true;
+    }
+
+    bool save(const std::string &path) const
+    {
+        cv::FileStorage fs(path, cv::FileStorage::WRITE);
+        if (!fs.isOpened())
+            return false;
+        fs << "cascade_scale_factor" << cascadeScaleFactor;
+        fs << "cascade_min_neighbors" << cascadeMinNeighbors;
+        fs << "canny_low" << cannyLow;
+        fs << "canny_high" << cannyHigh;
+        fs << "hough_rho" << houghRho;
+        fs << "hough_theta_divisor" << houghThetaDivisor;
+        fs << "hough_threshold" << houghThreshold;
+        fs << "hough_min_line_length" << houghMinLineLength;
+        fs << "hough_max_line_gap" << houghMaxLineGap;
+        fs << "hog_scale" << hogScale;
+        return true;
+    }
+
+private:
+    template <typename T>
+    static void read(const cv::FileStorage &fs, const char *key, T &value)
+    {
+        cv::FileNode node = fs[key];
+        if (!node.empty())
+            node >> value;
+    }
+};
+
+#endif // TUNING_CONFIG_HPP
@@ -0,0 +1,147 @@
+#ifndef VIDEO_SHARD_HPP
+#define VIDEO_SHARD_HPP
+
+#include <opencv2/core.hpp>     // Include for Mat and Size
+#include <opencv2/videoio.hpp>  // Include for the per-shard decoders and the merged output
+#include <algorithm>            // Include for max
+#include <climits>              // Include for LONG_MAX
+#include <cmath>                // Include for fabs
+#include <cstdio>               // Include for remove
+#include <fstream>              // Include for the record files
+#include <ostream>              // Include for writing the records
+#include <string>               // Include for the segment names
+#include <vector>               // Include for the shard plan
+
+#include "result_ring.hpp"      // Include for ResultRecord and the class names
+
+// Time-sharded processing of one long video. The frames are split into N consecutive shards that
+// are processed concurrently, each with its own VideoCapture. A shard starts decoding `overlap`
+// frames before its first frame and runs them through the pipeline without emitting them, so
+// stateful stages (smoothing, change detection, detector skip rates) have the same history as in a
+// sequential run. Every shard writes its frames and records to temporary segments that are
+// concatenated in shard order afterwards.
+//
+// Seeking uses CAP_PROP_POS_FRAMES: the FFmpeg backend seeks to the keyframe before the target and
+// decodes forward to it, so no shard has to start on a keyframe. Whether the seek really landed on
+// the target depends on the container index and the timestamps, so openShard checks the timestamp
+// of the decoded frame and falls back to decoding from the start when it does not match. The
+// warm-up overlap also hides the decode of the frames between keyframe and target.
+
+struct VideoShard
+{
+    int index;         // Position of the shard in the output
+    long warmupBegin;  // First decoded frame, frames before begin are processed but not emitted
+    long begin;        // First emitted frame
+    long end;          // One past the last emitted frame, LONG_MAX for the last shard (reads to the end)
+};
+
+// Split frameCount frames into shards of equal length. The last shard reads to the end of the file,
+// as the frame count reported by containers is not always exact.
+static inline std::vector<VideoShard> planShards(long frameCount, int shards, int overlap)
+{
+    std::vector<VideoShard> plan;
+    if (shards < 1)
+        shards = 1;
+    long length = std::max(1L, frameCount / shards);
+    for (int i = 0; i < shards; ++i)
+    {
+        long begin = i * length;
+        if (i > 0 && begin >= frameCount)
+            break;  // Fewer frames than shards
+        long end = (i == shards - 1) ? LONG_MAX : begin + length;
+        plan.push_back({(int)plan.size(), std::max(0L, begin - overlap), begin, end});
+    }
+    if (!plan.empty())
+        plan.back().end = LONG_MAX;
+    return plan;
+}
+
+// Open a decoder of its own for a shard, positioned at the first warm-up frame. The seek lands on
+// the frame before it, whose timestamp must match its frame number at the given rate within half a
+// frame; otherwise the decoder is re-opened and grabs forward from the first frame.
+static inline bool openShard(cv::VideoCapture &cap, const std::string &path, const VideoShard &shard, double fps)
+{
+    if (!cap.open(path))
+        return false;
+    if (shard.warmupBegin == 0)
+        return true;
+    long probe = shard.warmupBegin - 1;  // Frame decoded to check where the seek landed
+    if (fps > 0 && cap.set(cv::CAP_PROP_POS_FRAMES, (double)probe) && cap.grab())
+    {
+        double expected = probe * 1000.0 / fps;  // Timestamp of the probe frame in milliseconds
+        if (std::fabs(cap.get(cv::CAP_PROP_POS_MSEC) - expected) < 500.0 / fps)
+            return true;  // The next grab returns the first warm-up frame
+    }
+    cap.open(path);  // Missing index, variable frame rate or a seek that missed the frame
+    for (long position = 0; position < shard.warmupBegin; ++position)
+        if (!cap.grab())
+            return false;
+    return true;
+}
+
+// Name of the temporary segment of a shard, e.g. output.avi.shard3.avi
+static inline std::string shardSegmentName(const std::string &output, int index, const std::string &extension)
+{
+    return output + ".shard" + std::to_string(index) + extension;
+}
+
+// One line per lane and box, in the ground truth format of synthetic-scene-generator:
+// frame,lane,x1,y1,x2,y2, and frame,<class>,x,y,width,height,track ID. Readers of the ground truth
+// format ignore the extra id column.
+static inline void appendRecordCsv(std::ostream &os, const ResultRecord &r)
+{
+    for (int i = 0; i < r.laneCount; ++i)
+        os << r.frameIndex << ",lane," << r.lanes[i][0] << "," << r.lanes[i][1] << "," << r.lanes[i][2] << "," << r.lanes[i][3] << ",\n";
+    for (int i = 0; i < r.boxCount; ++i)
+        os << r.frameIndex << "," << resultClassName(r.boxes[i].cls) << "," << r.boxes[i].x << "," << r.boxes[i].y << ","
+           << r.boxes[i].w << "," << r.boxes[i].h << "," << r.boxes[i].trackId << "\n";
+}
+
+// Concatenate the record segments in shard order below a header line and remove them.
+// Fails when the output cannot be written or a segment is missing.
+static inline bool mergeRecordSegments(const std::vector<std::string> &segments, const std::string &output)
+{
+    std::ofstream out(output);
+    if (!out)
+        return false;
+    out << "frame,class,a,b,c,d,id\n";
+    bool complete = true;
+    for (const std::string &s : segments)
+    {
+        {
+            std::ifstream in(s);
+            if (!in.is_open())
+                complete = false;
+            else if (in.peek() != std::ifstream::traits_type::eof())
+                out << in.rdbuf();  // Streaming an empty file would set the failbit of out
+        }
+        std::remove(s.c_str());
+    }
+    return complete && (bool)out;
+}
+
+// Concatenate the video segments in shard order into one file and remove them. Fails when the
+// output cannot be opened (the segments are kept then) or a segment cannot be read. The segments
+// are decoded and encoded again, so the merged video is a second MJPG generation and slightly
+// softer than the output of a sequential run.
+static inline bool mergeVideoSegments(const std::vector<std::string> &segments, const std::string &output, double fps, cv::Size size)
+{
+    cv::VideoWriter writer(output, cv::VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, size, true);
+    if (!writer.isOpened())
+        return false;
+    bool complete = true;
+    cv::Mat frame;
+    for (const std::string &s : segments)
+    {
+        cv::VideoCapture in(s);
+        if (!in.isOpened())
+            complete = false;  // Missing or unreadable segment, the merged video has a gap
+        while (in.read(frame))
+            writer.write(frame);
+        in.release();
+        std::remove(s.c_str());
+    }
+    return complete;
+}
+
+#endif // VIDEO_SHARD_HPP
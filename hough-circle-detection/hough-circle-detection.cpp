@@ -7,6 +7,8 @@
 #include <opencv2/highgui/highgui.hpp> // Header for High-level GUI functionalities of OpenCV
 #include <opencv2/imgproc/imgproc.hpp> // Header for image processing functionalities of OpenCV
 
+#include "synthetic_scene.hpp"         // Procedural frame source for headless load testing
+
 using namespace cv;                // Use OpenCV's namespace for easier code writing
 using namespace std;               // Use standard namespace for easier code writing
 
@@ -15,38 +17,71 @@ using namespace std;               // Use standard namespace for easier code wri
 
 int main(int argc, char** argv)
 {
-    namedWindow("Capture Example", WINDOW_AUTOSIZE); // Create a window for display
     VideoCapture capture;                            // Create a VideoCapture object to capture video from a device
     Mat frame, gray;                                 // Declare matrices to hold the frames and grayscale images
     vector<Vec3f> circles;                           // Declare a vector to hold circle parameters
 
     int dev = 0;                                     // Default device ID is 0
+    string syntheticSpec;                            // Resolution of the synthetic scene, empty to use the camera
+    bool headless = false;                           // Do not open any window
+    int maxFrames = -1;                              // Number of frames to process, negative for endless
 
-    if (argc > 1)                                    // If there are more than one command-line arguments
+    for (int i = 1; i < argc; i++)                   // Parse the command-line arguments
     {
-        sscanf(argv[1], "%d", &dev);                 // Convert the first argument to an integer (device ID)
-        cout << "Using " << argv[1] << endl;         // Print the device ID being used
+        string arg = argv[i];
+        if (arg == "--synthetic" && i + 1 < argc)    // Use the synthetic scene instead of the camera
+            syntheticSpec = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc)  // Stop after a number of frames
+            maxFrames = atoi(argv[++i]);
+        else if (arg == "--headless")                // Run without any window
+            headless = true;
+        else if (sscanf(argv[i], "%d", &dev) == 1)   // Convert the argument to an integer (device ID)
+            cout << "Using " << argv[i] << endl;     // Print the device ID being used
+        else                                         // Unknown argument
+        {
+            cout << "usage: capture [dev] [--synthetic <W>x<H>[@fps]] [--frames <n>] [--headless]" << endl; // Print usage instructions
+            exit(-1);                                // Exit with error code -1
+        }
     }
-    else if (argc == 1)                              // If there is only one command-line argument
+
+    Size syntheticSize;                              // Resolution of the synthetic scene
+    double syntheticFps = 30.0;                      // Frame rate of the synthetic scene
+    if (!syntheticSpec.empty() && !SyntheticScene::parseSpec(syntheticSpec, syntheticSize, syntheticFps))
     {
-        cout << "Using default" << endl;             // Print that the default device is being used
+        cout << "Invalid synthetic resolution: " << syntheticSpec << endl; // Print the rejected spec
+        exit(-1);                                    // Exit with error code -1
     }
-    else                                             // If no command-line arguments are provided
+    SyntheticScene scene(syntheticSize, syntheticFps); // Synthetic frame source, only used with --synthetic
+    scene.setFrameLimit(maxFrames);                  // The scene ends like a video file after maxFrames
+
+    if (syntheticSpec.empty())
     {
-        cout << "usage: capture [dev]" << endl;      // Print usage instructions
-        exit(-1);                                    // Exit with error code -1
+        if (argc == 1)                               // If there is only one command-line argument
+            cout << "Using default" << endl;         // Print that the default device is being used
+        capture.open(dev);                           // Open the video capture with the specified device ID
+        capture.set(CAP_PROP_FRAME_WIDTH, HRES);     // Set the frame width
+        capture.set(CAP_PROP_FRAME_HEIGHT, VRES);    // Set the frame height
     }
 
-    capture.open(dev);                               // Open the video capture with the specified device ID
-    capture.set(CAP_PROP_FRAME_WIDTH, HRES);         // Set the frame width
-    capture.set(CAP_PROP_FRAME_HEIGHT, VRES);        // Set the frame height
+    if (!headless)
+        namedWindow("Capture Example", WINDOW_AUTOSIZE); // Create a window for display
+
+    int processed = 0;                               // Number of processed frames
+    int64 start = getTickCount();                    // Start time for the throughput report
 
     while (1)                                        // Infinite loop to continuously capture frames
     {
-        capture >> frame;                            // Capture a new frame
+        if (maxFrames >= 0 && processed >= maxFrames) // Stop after the requested number of frames
+            break;                                   // Exit the loop
+
+        if (syntheticSpec.empty())
+            capture >> frame;                        // Capture a new frame
+        else
+            scene >> frame;                          // Render a new synthetic frame
 
         if (frame.empty())                           // If the frame is empty (end of video or error)
             break;                                   // Exit the loop
+        processed++;                                 // Count the frame for the throughput report
 
         Mat mat_frame(frame);                        // Convert the captured frame to a Mat object
 
@@ -57,7 +92,8 @@ int main(int argc, char** argv)
         // Detect circles in the grayscale image using the Hough Circle Transform
         HoughCircles(gray, circles, HOUGH_GRADIENT, 1, gray.rows / 8, 100, 50, 0, 0);
 
-        printf("circles.size = %ld\n", circles.size()); // Print the number of circles detected
+        if (!headless)                               // Keep the console quiet while load testing
+            printf("circles.size = %ld\n", circles.size()); // Print the number of circles detected
 
         for (size_t i = 0; i < circles.size(); i++)  // Loop through all detected circles
         {
@@ -69,6 +105,9 @@ int main(int argc, char** argv)
             circle(mat_frame, center, radius, Scalar(0, 0, 255), 3, 8, 0);
         }
 
+        if (headless)                                // No window to update in headless mode
+            continue;
+
         imshow("Capture Example", mat_frame);        // Display the frame with detected circles
 
         char c = waitKey(10);                        // Wait for 10 milliseconds for a key press
@@ -76,5 +115,8 @@ int main(int argc, char** argv)
             break;                                   // Exit the loop
     }
 
+    double seconds = (getTickCount() - start) / getTickFrequency(); // Total processing time
+    cout << "Processed " << processed << " frames, " << (seconds > 0 ? processed / seconds : 0.0) << " frames/second" << endl;
+
     return 0;                                        // Return success code 0
 }
@@ -7,6 +7,9 @@
 #include <opencv2/highgui/highgui.hpp> // Header for High-level GUI functionalities of OpenCV
 #include <opencv2/imgproc/imgproc.hpp> // Header for image processing functionalities of OpenCV
 
+#include "synthetic_scene.hpp"         // Procedural frame source for headless load testing
+#include "tuning_config.hpp"           // HoughLinesP parameters written by auto-tuner
+
 using namespace cv;                // Use OpenCV's namespace for easier code writing
 using namespace std;               // Use standard namespace for easier code writing
 
@@ -15,38 +18,83 @@ using namespace std;               // Use standard namespace for easier code wri
 
 int main(int argc, char** argv)
 {
-    namedWindow("Capture Example", WINDOW_AUTOSIZE); // Create a window for display with automatic size adjustment
     VideoCapture capture;                            // Create a VideoCapture object to capture video from a device
     Mat frame, gray, canny_frame, cdst;              // Declare matrices to hold frames, grayscale images, Canny edge detected images, and color images
     vector<Vec4i> lines;                             // Declare a vector to hold line parameters from Hough Transform
 
     int dev = 0;                                     // Default device ID is 0
+    string syntheticSpec;                            // Resolution of the synthetic scene, empty to use the camera
+    bool headless = false;                           // Do not open any window
+    int maxFrames = -1;                              // Number of frames to process, negative for endless
+    string configPath;                               // Tuning config, empty to use ./tuning.yml when present
 
-    if (argc > 1)                                    // If there are more than one command-line arguments
+    for (int i = 1; i < argc; i++)                   // Parse the command-line arguments
     {
-        sscanf(argv[1], "%d", &dev);                 // Convert the first argument to an integer (device ID)
-        cout << "Using " << argv[1] << endl;         // Print the device ID being used
+        string arg = argv[i];
+        if (arg == "--synthetic" && i + 1 < argc)    // Use the synthetic scene instead of the camera
+            syntheticSpec = argv[++i];
+        else if (arg == "--frames" && i + 1 < argc)  // Stop after a number of frames
+            maxFrames = atoi(argv[++i]);
+        else if (arg == "--headless")                // Run without any window
+            headless = true;
+        else if (arg == "--config" && i + 1 < argc)  // Load the Hough parameters from a tuning config
+            configPath = argv[++i];
+        else if (sscanf(argv[i], "%d", &dev) == 1)   // Convert the argument to an integer (device ID)
+            cout << "Using " << argv[i] << endl;     // Print the device ID being used
+        else                                         // Unknown argument
+        {
+            cout << "Usage: capture [dev] [--synthetic <W>x<H>[@fps]] [--frames <n>] [--headless] [--config <tuning.yml>]" << endl; // Print usage instructions
+            return -1;                               // Return with error code -1
+        }
     }
-    else if (argc == 1)                              // If there is only one command-line argument
+
+    TuningConfig tuning;                             // Hough parameters, the defaults match the untuned program
+    if (!configPath.empty() && !tuning.load(configPath))
     {
-        cout << "Using default" << endl;             // Print that the default device is being used
+        cout << "Unable to read config: " << configPath << endl; // Print the rejected config
+        return -1;                                   // Return with error code -1
     }
-    else                                             // If no command-line arguments are provided
+    if (configPath.empty())
+        tuning.load("tuning.yml");                   // Optional config of the working directory
+
+    Size syntheticSize;                              // Resolution of the synthetic scene
+    double syntheticFps = 30.0;                      // Frame rate of the synthetic scene
+    if (!syntheticSpec.empty() && !SyntheticScene::parseSpec(syntheticSpec, syntheticSize, syntheticFps))
     {
-        cout << "Usage: capture [dev]" << endl;      // Print usage instructions
+        cout << "Invalid synthetic resolution: " << syntheticSpec << endl; // Print the rejected spec
         return -1;                                   // Return with error code -1
     }
+    SyntheticScene scene(syntheticSize, syntheticFps); // Synthetic frame source, only used with --synthetic
+    scene.setFrameLimit(maxFrames);                  // The scene ends like a video file after maxFrames
+
+    if (syntheticSpec.empty())
+    {
+        if (argc == 1)                               // If there is only one command-line argument
+            cout << "Using default" << endl;         // Print that the default device is being used
+        capture.open(dev);                           // Open the video capture with the specified device ID
+        capture.set(CAP_PROP_FRAME_WIDTH, HRES);     // Set the frame width
+        capture.set(CAP_PROP_FRAME_HEIGHT, VRES);    // Set the frame height
+    }
 
-    capture.open(dev);                               // Open the video capture with the specified device ID
-    capture.set(CAP_PROP_FRAME_WIDTH, HRES);         // Set the frame width
-    capture.set(CAP_PROP_FRAME_HEIGHT, VRES);        // Set the frame height
+    if (!headless)
+        namedWindow("Capture Example", WINDOW_AUTOSIZE); // Create a window for display with automatic size adjustment
+
+    int processed = 0;                               // Number of processed frames
+    int64 start = getTickCount();                    // Start time for the throughput report
 
     while (1)                                        // Infinite loop to continuously capture frames
     {
-        capture >> frame;                            // Capture a new frame
+        if (maxFrames >= 0 && processed >= maxFrames) // Stop after the requested number of frames
+            break;                                   // Exit the loop
+
+        if (syntheticSpec.empty())
+            capture >> frame;                        // Capture a new frame
+        else
+            scene >> frame;                          // Render a new synthetic frame
 
         if (frame.empty())                           // If the frame is empty (end of video or error)
             break;                                   // Exit the loop
+        processed++;                                 // Count the frame for the throughput report
 
         // Apply Canny edge detection
         Canny(frame, canny_frame, 50, 200, 3);
@@ -58,7 +106,7 @@ int main(int argc, char** argv)
         cvtColor(frame, gray, COLOR_BGR2GRAY);
 
         // Detect lines in the grayscale image using the Hough Line Transform
-        HoughLinesP(canny_frame, lines, 1, CV_PI / 360, 50, 5, 2);
+        HoughLinesP(canny_frame, lines, tuning.houghRho, CV_PI / tuning.houghThetaDivisor, tuning.houghThreshold, tuning.houghMinLineLength, tuning.houghMaxLineGap);
 
         // Loop through all detected lines and draw them on the frame
         for (size_t i = 0; i < lines.size(); i++)
@@ -67,6 +115,9 @@ int main(int argc, char** argv)
             line(frame, Point(l[0], l[1]), Point(l[2], l[3]), Scalar(0, 0, 255), 1, LINE_AA); // Draw the line on the frame
         }
 
+        if (headless)                                // No window to update in headless mode
+            continue;
+
         imshow("Capture Example", frame);            // Display the frame with detected lines
 
         char c = waitKey(10);                        // Wait for 10 milliseconds for a key press
@@ -74,5 +125,8 @@ int main(int argc, char** argv)
             break;                                   // Exit the loop
     }
 
+    double seconds = (getTickCount() - start) / getTickFrequency(); // Total processing time
+    cout << "Processed " << processed << " frames, " << (seconds > 0 ? processed / seconds : 0.0) << " frames/second" << endl;
+
     return 0;                                        // Return success code 0
 }
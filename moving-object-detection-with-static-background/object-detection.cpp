@@ -1,17 +1,217 @@
 #include <opencv2/opencv.hpp> // Include the OpenCV library header for all necessary OpenCV functions
 #include <iostream>           // Include the header for standard input/output stream objects
+#include <fstream>            // Include the header for the record segments of the sharded mode
+#include <thread>             // Include the header for the shard workers
+
+#include "result_ring.hpp"    // Shared memory ring publishing the per-frame results
+#include "change_detector.hpp" // Skips the processing while the scene does not change
+#include "video_shard.hpp"    // Splitting one long video into segments processed in parallel
 
 using namespace cv;           // Use the OpenCV namespace for easier code writing
 using namespace std;          // Use the standard namespace for easier code writing
 
+// Image, centre of mass and bounding box of the bright region of the last processed frame
+struct BlobResult
+{
+    Mat grayImage;                             // Processed image with the cross hair at the centre of mass
+    int centerOfMassX = 0, centerOfMassY = 0;  // Centre of mass of the points above the threshold
+    int minX = 0, minY = 0, maxX = -1, maxY = -1; // Bounding box of the points above the threshold
+};
+
+// Resize the frame and track the bright region; frames the change detector considers unchanged keep the previous result
+void processFrame(Mat &mat_frame, BlobResult &res, ChangeDetector &change)
+{
+    resize(mat_frame, mat_frame, Size(640, 480)); // Resize the frame to 640x480 resolution
+
+    if (!change.changed(mat_frame)) // Static frames re-emit the image and results of the last processed frame
+        return;
+
+    int totalPoint = 0;              // Initialize totalPoint to count points above the threshold
+    int massX = 0;                   // Initialize massX to accumulate x-coordinates of points above the threshold
+    int massY = 0;                   // Initialize massY to accumulate y-coordinates of points above the threshold
+    res.minX = mat_frame.cols, res.minY = mat_frame.rows, res.maxX = -1, res.maxY = -1; // Bounding box of the points above the threshold
+    res.grayImage.create(mat_frame.rows, mat_frame.cols, CV_8UC1); // Create a grayscale image with the same dimensions as the frame
+    uchar threshold = 100;           // Set the threshold value for detecting bright spots
+    for (int y = 0; y < mat_frame.rows; ++y) // Iterate over all rows of the frame
+    {
+        for (int x = 0; x < mat_frame.cols; ++x) // Iterate over all columns of the frame
+        {
+            Vec3b pixel = mat_frame.at<Vec3b>(y, x); // Get the BGR pixel value at (x, y)
+            uchar grayVal = static_cast<uchar>(0.299 * pixel[2] + 0.587 * pixel[1] + 0.114 * pixel[0]); // Convert BGR to grayscale using standard conversion formula
+            res.grayImage.at<uchar>(y, x) = 0; // Initialize the grayscale image pixel to 0
+            if (threshold < grayVal) // Check if the grayscale value is above the threshold
+            {
+                totalPoint++; // Increment the count of points above the threshold
+                massX += x; // Accumulate the x-coordinate of the point
+                massY += y; // Accumulate the y-coordinate of the point
+                res.minX = min(res.minX, x), res.maxX = max(res.maxX, x); // Grow the bounding box
+                res.minY = min(res.minY, y), res.maxY = max(res.maxY, y);
+            }
+        }
+    }
+
+    res.centerOfMassX = static_cast<int>(massX / totalPoint); // Calculate the x-coordinate of the center of mass
+    res.centerOfMassY = static_cast<int>(massY / totalPoint); // Calculate the y-coordinate of the center of mass
+
+    for (int y = 0; y < mat_frame.rows; ++y) // Iterate over all rows to draw a vertical line at the center of mass
+    {
+        res.grayImage.at<uchar>(y, res.centerOfMassX) = 255; // Set the pixel at (res.centerOfMassX, y) to white
+        if ((res.centerOfMassX - 1) > 0) // Check if the pixel to the left of the center is within bounds
+        {
+            res.grayImage.at<uchar>(y, res.centerOfMassX - 1) = 255; // Set the left pixel to white
+        }
+
+        if ((res.centerOfMassX + 1) < mat_frame.cols) // Check if the pixel to the right of the center is within bounds
+        {
+            res.grayImage.at<uchar>(y, res.centerOfMassX + 1) = 255; // Set the right pixel to white
+        }
+    }
+
+    for (int x = 0; x < mat_frame.cols; ++x) // Iterate over all columns to draw a horizontal line at the center of mass
+    {
+        res.grayImage.at<uchar>(res.centerOfMassY, x) = 255; // Set the pixel at (x, res.centerOfMassY) to white
+        if ((res.centerOfMassY - 1) > 0) // Check if the pixel above the center is within bounds
+        {
+            res.grayImage.at<uchar>(res.centerOfMassY - 1, x) = 255; // Set the above pixel to white
+        }
+        if ((res.centerOfMassY + 1) < mat_frame.rows) // Check if the pixel below the center is within bounds
+        {
+            res.grayImage.at<uchar>(res.centerOfMassY + 1, x) = 255; // Set the below pixel to white
+        }
+    }
+}
+
+// Describe the bright region of a frame as one RESULT_BLOB box with its centre of mass
+void fillRecord(ResultRecord &record, const BlobResult &res, uint64_t frameIndex, double mediaTimeMs)
+{
+    record.clear();
+    record.frameIndex = frameIndex;
+    record.mediaTimeMs = mediaTimeMs;
+    record.addBox(RESULT_BLOB, Rect(res.minX, res.minY, res.maxX - res.minX + 1, res.maxY - res.minY + 1), (float)res.centerOfMassX, (float)res.centerOfMassY);
+}
+
+// Process the video as consecutive shards in parallel, one thread and decoder per shard. Every shard
+// runs `overlap` frames before its first frame to give the change detector its history; the images
+// are written as frame<n>.pgm as in the sequential run and the records are merged in order.
+int runSharded(const string &videoFile, int shards, int overlap, const string &recordsFile, double skipThreshold, int maxSkip)
+{
+    VideoCapture probe(videoFile); // Only used for the frame count and rate
+    if (!probe.isOpened())
+    {
+        cout << "Error opening video stream or file" << endl; // Print error message if the file cannot be opened
+        return -1;
+    }
+    long frameCount = (long)probe.get(CAP_PROP_FRAME_COUNT);
+    double fps = probe.get(CAP_PROP_FPS);
+    probe.release();
+
+    vector<VideoShard> plan = planShards(frameCount, shards, overlap);
+    vector<string> recordSegments; // Temporary record files of the shards
+    for (const VideoShard &shard : plan)
+        recordSegments.push_back(shardSegmentName(recordsFile, shard.index, ".csv"));
+    vector<long> emitted(plan.size(), 0); // Frames written by every shard
+    vector<int> failed(plan.size(), 0);   // Shards whose decoder could not be positioned
+
+    int64 start = getTickCount(); // Start time for the throughput report
+    vector<thread> threads;
+    for (size_t s = 0; s < plan.size(); ++s)
+    {
+        threads.emplace_back([&, s]() {
+            const VideoShard &shard = plan[s];
+            VideoCapture cap;
+            if (!openShard(cap, videoFile, shard, fps))
+            {
+                failed[s] = 1;
+                return;
+            }
+            ChangeDetector change(skipThreshold, maxSkip); // State of this shard
+            BlobResult res;
+            ResultRecord record;
+            ofstream records;
+            if (!recordsFile.empty())
+                records.open(recordSegments[s]);
+            Mat frame;
+            for (long position = shard.warmupBegin; position < shard.end && cap.read(frame); ++position)
+            {
+                processFrame(frame, res, change); // Track the bright region of the frame
+                if (position < shard.begin)
+                    continue; // Warm-up frame, only there for the history of the change detector
+                imwrite("frame" + to_string(position + 1) + ".pgm", res.grayImage); // Same names as the sequential run
+                if (records.is_open())
+                {
+                    fillRecord(record, res, (uint64_t)position, fps > 0 ? 1000.0 * position / fps : -1.0);
+                    appendRecordCsv(records, record);
+                }
+                emitted[s]++;
+            }
+        });
+    }
+    for (thread &t : threads)
+        t.join();
+
+    long total = 0; // Frames of all shards
+    for (size_t s = 0; s < plan.size(); ++s)
+    {
+        if (failed[s])
+        {
+            cout << "Error seeking shard " << s << " to frame " << plan[s].warmupBegin << endl;
+            return -1;
+        }
+        total += emitted[s];
+    }
+    if (!recordsFile.empty() && !mergeRecordSegments(recordSegments, recordsFile))
+    {
+        cout << "Error writing " << recordsFile << endl;
+        return -1;
+    }
+    double seconds = (getTickCount() - start) / getTickFrequency(); // Processing and merge of the shards
+    cout << "Processed " << total << " frames in " << plan.size() << " shards, " << (seconds > 0 ? total / seconds : 0.0) << " frames/second" << endl;
+    return 0;
+}
+
 int main(int argc, char **argv) // Main function taking command-line arguments
 {
     if (argc < 2) {
-        cout << "Usage: " << argv[0] << " <video-file>" << endl;
+        cout << "Usage: " << argv[0] << " <video-file> [--publish <ring-name> [--publish-frames]] [--skip-static <threshold> [--max-skip <n>]] [--shards <n> [--overlap <frames>] [--records <file.csv>]]" << endl;
         return -1;
     }
 
     string videoFile = argv[1];
+    string publishName;                // Name of the shared memory result ring, empty disables publishing
+    bool publishFrames = false;        // Publish the processed frames next to the results
+    double skipThreshold = 0.0;        // Block difference below which a frame reuses the previous results, 0 disables
+    int maxSkip = 30;                  // Frames skipped in a row before one is processed anyway
+    int shards = 1;                    // Segments of the video processed in parallel
+    int overlap = 30;                  // Warm-up frames of every shard
+    string recordsFile;                // Per-frame records of the sharded mode
+    for (int i = 2; i < argc; ++i)     // Parse the optional flags
+    {
+        string arg = argv[i];
+        if (arg == "--publish" && i + 1 < argc) publishName = argv[++i];
+        else if (arg == "--publish-frames") publishFrames = true;
+        else if (arg == "--skip-static" && i + 1 < argc) skipThreshold = atof(argv[++i]);
+        else if (arg == "--max-skip" && i + 1 < argc) maxSkip = atoi(argv[++i]);
+        else if (arg == "--shards" && i + 1 < argc) shards = max(1, atoi(argv[++i]));
+        else if (arg == "--overlap" && i + 1 < argc) overlap = max(0, atoi(argv[++i]));
+        else if (arg == "--records" && i + 1 < argc) recordsFile = argv[++i];
+        else
+        {
+            cout << "Unknown argument: " << arg << endl;
+            return -1;
+        }
+    }
+    if (shards > 1 || !recordsFile.empty()) // Sharded mode, no window and no ring
+    {
+        if (!publishName.empty())
+        {
+            cout << "--publish is not available with --shards or --records" << endl;
+            return -1;
+        }
+        return runSharded(videoFile, shards, overlap, recordsFile, skipThreshold, maxSkip);
+    }
+
+    ResultRingWriter ring;             // Shared memory publisher of the results
+    ResultRecord record;               // Results of the current frame
     VideoCapture vcap;         // Create a VideoCapture object for capturing video from a file or camera
     Mat mat_frame;             // Declare a matrix to hold each video frame
     if (!vcap.open(videoFile)) // Attempt to open the specified video file
@@ -21,6 +221,8 @@ int main(int argc, char **argv) // Main function taking command-line arguments
     }
 
     int frame_count = 1;                 // Initialize frame count to 1
+    ChangeDetector change(skipThreshold, maxSkip); // Front end deciding whether a frame has to be processed
+    BlobResult res;                      // Result of the last processed frame, carried over to unchanged frames
 
     while (1)                            // Infinite loop to continuously capture and process frames
     {
@@ -29,70 +231,32 @@ int main(int argc, char **argv) // Main function taking command-line arguments
             cout << "No frame" << endl;  // Print error message if no frame is captured
             break;                       // Exit the loop if no frame is captured
         }
-        resize(mat_frame, mat_frame, Size(640, 480)); // Resize the frame to 640x480 resolution
-
-        int totalPoint = 0;              // Initialize totalPoint to count points above the threshold
-        int massX = 0;                   // Initialize massX to accumulate x-coordinates of points above the threshold
-        int massY = 0;                   // Initialize massY to accumulate y-coordinates of points above the threshold
-        Mat grayImage(mat_frame.rows, mat_frame.cols, CV_8UC1); // Create a grayscale image with the same dimensions as the frame
-        uchar threshold = 100;           // Set the threshold value for detecting bright spots
-        if (frame_count > -1)            // Process the frame if frame_count is valid
-        {
-            for (int y = 0; y < mat_frame.rows; ++y) // Iterate over all rows of the frame
-            {
-                for (int x = 0; x < mat_frame.cols; ++x) // Iterate over all columns of the frame
-                {
-                    Vec3b pixel = mat_frame.at<Vec3b>(y, x); // Get the BGR pixel value at (x, y)
-                    uchar grayVal = static_cast<uchar>(0.299 * pixel[2] + 0.587 * pixel[1] + 0.114 * pixel[0]); // Convert BGR to grayscale using standard conversion formula
-                    grayImage.at<uchar>(y, x) = 0; // Initialize the grayscale image pixel to 0
-                    if (threshold < grayVal) // Check if the grayscale value is above the threshold
-                    {
-                        totalPoint++; // Increment the count of points above the threshold
-                        massX += x; // Accumulate the x-coordinate of the point
-                        massY += y; // Accumulate the y-coordinate of the point
-                    }
-                }
-            }
-        }
-
-        int centerOfMassX = static_cast<int>(massX / totalPoint); // Calculate the x-coordinate of the center of mass
-        int centerOfMassY = static_cast<int>(massY / totalPoint); // Calculate the y-coordinate of the center of mass
+        processFrame(mat_frame, res, change); // Track the bright region of the frame
 
-        for (int y = 0; y < mat_frame.rows; ++y) // Iterate over all rows to draw a vertical line at the center of mass
+        if (!publishName.empty()) // Hand the results to downstream consumers
         {
-            grayImage.at<uchar>(y, centerOfMassX) = 255; // Set the pixel at (centerOfMassX, y) to white
-            if ((centerOfMassX - 1) > 0) // Check if the pixel to the left of the center is within bounds
+            if (!ring.isOpened() && !ring.open(publishName, publishFrames ? 16 : 256, publishFrames ? res.grayImage.size() : Size(), res.grayImage.type()))
             {
-                grayImage.at<uchar>(y, centerOfMassX - 1) = 255; // Set the left pixel to white
-            }
-
-            if ((centerOfMassX + 1) < mat_frame.cols) // Check if the pixel to the right of the center is within bounds
-            {
-                grayImage.at<uchar>(y, centerOfMassX + 1) = 255; // Set the right pixel to white
-            }
-        }
-
-        for (int x = 0; x < mat_frame.cols; ++x) // Iterate over all columns to draw a horizontal line at the center of mass
-        {
-            grayImage.at<uchar>(centerOfMassY, x) = 255; // Set the pixel at (x, centerOfMassY) to white
-            if ((centerOfMassY - 1) > 0) // Check if the pixel above the center is within bounds
-            {
-                grayImage.at<uchar>(centerOfMassY - 1, x) = 255; // Set the above pixel to white
-            }
-            if ((centerOfMassY + 1) < mat_frame.rows) // Check if the pixel below the center is within bounds
-            {
-                grayImage.at<uchar>(centerOfMassY + 1, x) = 255; // Set the below pixel to white
+                cout << "Error creating result ring " << publishName << endl; // Print error message
+                return -1;                   // Exit the program with an error code
             }
+            fillRecord(record, res, frame_count - 1, vcap.get(CAP_PROP_POS_MSEC)); // Start a new record
+            ring.publish(record, res.grayImage);
         }
 
         string filename = "frame" + to_string(frame_count) + ".pgm"; // Create a filename for the current frame
-        imwrite(filename, grayImage); // Save the grayscale image as a PGM file
+        imwrite(filename, res.grayImage); // Save the grayscale image as a PGM file
         frame_count++; // Increment the frame count
 
         imshow("Original", mat_frame); // Display the original frame in a window
-        imshow("Frame", grayImage); // Display the processed grayscale image in a window
+        imshow("Frame", res.grayImage); // Display the processed grayscale image in a window
         char c = waitKey(33); // Wait for 33 milliseconds for a key press
         if (c == 'q') // If the 'q' key is pressed
             break; // Exit the loop
     }
+
+    ring.unlink(); // Remove the result ring, attached consumers keep their mapping
+
+    if (change.enabled())
+        cout << "Change detector: " << change.processedCount() << " frames processed, " << change.skippedCount() << " static frames skipped" << endl;
 }
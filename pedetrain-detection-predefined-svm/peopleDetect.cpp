@@ -5,6 +5,11 @@
 #include <iostream>               // Include the header for standard input/output stream objects
 #include <iomanip>                // Include the header for input/output manipulations
 
+#include "result_ring.hpp"        // Shared memory ring publishing the per-frame results
+#include "tuning_config.hpp"      // Detection scale written by auto-tuner
+#include "change_detector.hpp"    // Skips the detector while the scene does not change
+#include "detection_fusion.hpp"   // Suppression of duplicate boxes and track IDs
+
 using namespace cv;               // Use the OpenCV namespace for easier code writing
 using namespace std;              // Use the standard namespace for easier code writing
 
@@ -20,10 +25,11 @@ class Detector
 
     // HOG descriptors for the default and Daimler people detectors
     HOGDescriptor hog, hog_d;
+    double scale;  // Scale between two pyramid levels of the default detector
 
 public:
     // Constructor to initialize the HOG descriptors and set the SVM detectors
-    Detector() : m(Default), hog(), hog_d(Size(48, 96), Size(16, 16), Size(8, 8), Size(8, 8), 9)
+    explicit Detector(double defaultScale = 1.05) : m(Default), hog(), hog_d(Size(48, 96), Size(16, 16), Size(8, 8), Size(8, 8), 9), scale(defaultScale)
     {
         hog.setSVMDetector(HOGDescriptor::getDefaultPeopleDetector());     // Set the default people detector
         hog_d.setSVMDetector(HOGDescriptor::getDaimlerPeopleDetector());   // Set the Daimler people detector
@@ -35,14 +41,14 @@ public:
     // Return the name of the current mode as a string
     string modeName() const { return (m == Default ? "Default" : "Daimler"); }
 
-    // Function to detect people in the input image
-    vector<Rect> detect(InputArray img)
+    // Function to detect people in the input image, weights receives the SVM score of every rectangle
+    vector<Rect> detect(InputArray img, vector<double> &weights)
     {
         vector<Rect> found;  // Vector to store the detected rectangles
         if (m == Default)
-            hog.detectMultiScale(img, found, 0, Size(8, 8), Size(32, 32), 1.05, 2, false);  // Default detection
+            hog.detectMultiScale(img, found, weights, 0, Size(8, 8), Size(32, 32), scale, 2, false);  // Default detection with the tuned scale
         else if (m == Daimler)
-            hog_d.detectMultiScale(img, found, 0.5, Size(8, 8), Size(32, 32), 1.05, 2, true); // Daimler detection
+            hog_d.detectMultiScale(img, found, weights, 0.5, Size(8, 8), Size(32, 32), 1.05, 2, true); // Daimler detection
         return found;  // Return the detected rectangles
     }
 
@@ -59,7 +65,12 @@ public:
 // Define command-line parser keys
 static const string keys = "{ help h | | print help message }"
                            "{ camera c | 0 | capture video from camera (device index starting from 0) }"
-                           "{ video v | | use video as input }";
+                           "{ video v | | use video as input }"
+                           "{ publish | | publish the results to this shared memory ring, e.g. /people }"
+                           "{ publish_frames | | also publish the processed frames }"
+                           "{ config | tuning.yml | tuning config written by auto-tuner, missing file keeps the defaults }"
+                           "{ skip_static | 0 | reuse the boxes of the previous frame while no 8x8 block changes by more than this, 0 disables }"
+                           "{ max_skip | 30 | frames skipped in a row before the detector runs anyway }";
 
 // Main function
 int main(int argc, char **argv)
@@ -99,9 +110,24 @@ int main(int argc, char **argv)
     cout << "Press 'q' or <ESC> to quit." << endl; // Print message for quitting
     cout << "Press <space> to toggle between Default and Daimler detector" << endl; // Print message for toggling the detector
 
-    Detector detector; // Create a Detector object
+    TuningConfig tuning; // Detection scale, the default matches the untuned program
+    if (tuning.load(parser.get<string>("config"))) // Optional config written by auto-tuner
+        cout << "Loaded " << parser.get<string>("config") << ", HOG scale " << tuning.hogScale << endl; // Print the tuned scale
+    Detector detector(tuning.hogScale); // Create a Detector object
     Mat frame; // Create a matrix to hold each video frame
 
+    string publishName = parser.get<string>("publish"); // Name of the result ring, empty disables publishing
+    bool publishFrames = parser.has("publish_frames"); // Publish the processed frames next to the results
+    ResultRingWriter ring; // Shared memory publisher of the results
+    ResultRecord record; // Results of the current frame
+    uint64_t frameIndex = 0; // Index of the current frame
+    ChangeDetector change(parser.get<double>("skip_static"), parser.get<int>("max_skip")); // Front end deciding whether the detector has to run
+    vector<double> weights; // SVM score of every raw box
+    DetectionFusion fusion; // Removes overlapping boxes the grouping left and keeps the IDs of the people
+    vector<Detection> people; // Fused boxes of the last processed frame, carried over to unchanged frames
+    double detectFps = 0; // Detection rate of the last processed frame, skipped frames do not change it
+    double detectSeconds = 0; // Detection time of all processed frames
+
     for (;;) // Infinite loop to process each frame
     {
         cap >> frame; // Capture the next frame
@@ -111,25 +137,53 @@ int main(int argc, char **argv)
             break; // Exit the loop
         }
 
-        int64 t = getTickCount(); // Get the current tick count
-        vector<Rect> found = detector.detect(frame); // Detect people in the frame
-        t = getTickCount() - t; // Calculate the detection time
+        if (change.changed(frame)) // Static frames re-emit the boxes of the last processed frame
+        {
+            int64 t = getTickCount(); // Get the current tick count
+            vector<Rect> found = detector.detect(frame, weights); // Detect people in the frame
+            people.clear();
+            for (size_t k = 0; k < found.size(); ++k)
+                people.push_back({found[k], RESULT_PERSON, k < weights.size() ? (float)weights[k] : 1.0f});
+            fusion.apply(people, frame.size()); // Suppression and tracking on the raw HOG windows
+            for (Detection &d : people)
+                detector.adjustRect(d.box); // Adjust the rectangle once, the carried boxes are already adjusted
+            t = getTickCount() - t; // Calculate the detection time
+            detectFps = getTickFrequency() / (double)t;
+            detectSeconds += t / getTickFrequency();
+        }
 
-        // Display the detection mode and FPS on the frame
+        // Display the detection mode, the FPS of the processed frames and the share of skipped frames on the frame
         {
             ostringstream buf; // Create a string buffer
             buf << "Mode: " << detector.modeName() << " ||| " // Append the detection mode
-                << "FPS: " << fixed << setprecision(1) << (getTickFrequency() / (double)t); // Append the FPS
+                << "FPS: " << fixed << setprecision(1) << detectFps; // Append the FPS
+            if (change.enabled())
+                buf << " ||| Skipped: " << setprecision(0) << 100.0 * change.skippedCount() / (change.processedCount() + change.skippedCount()) << "%"; // Append the skip ratio
             putText(frame, buf.str(), Point(10, 30), FONT_HERSHEY_PLAIN, 2.0, Scalar(0, 0, 255), 2, LINE_AA); // Draw the text on the frame
         }
 
-        for (vector<Rect>::iterator i = found.begin(); i != found.end(); ++i) // Iterate over all detected rectangles
+        for (const Detection &d : people) // Iterate over all detected people
         {
-            Rect &r = *i; // Get the current rectangle
-            detector.adjustRect(r); // Adjust the rectangle
-            rectangle(frame, r.tl(), r.br(), cv::Scalar(0, 255, 0), 2); // Draw the rectangle on the frame
+            rectangle(frame, d.box.tl(), d.box.br(), cv::Scalar(0, 255, 0), 2); // Draw the rectangle on the frame
+            putText(frame, to_string(d.trackId), Point(d.box.x, max(12, d.box.y - 4)), FONT_HERSHEY_PLAIN, 1.0, Scalar(0, 255, 0), 1); // Draw the track ID above it
         }
 
+        if (!publishName.empty()) // Hand the results to downstream consumers
+        {
+            if (!ring.isOpened() && !ring.open(publishName, publishFrames ? 16 : 256, publishFrames ? frame.size() : Size(), frame.type()))
+            {
+                cout << "Can not create result ring: '" << publishName << "'" << endl; // Print error message
+                return 3; // Exit the program with an error code
+            }
+            record.clear(); // Start a new record
+            record.frameIndex = frameIndex;
+            record.mediaTimeMs = cap.get(CAP_PROP_POS_MSEC);
+            for (const Detection &d : people)
+                record.addBox(RESULT_PERSON, d.box, d.trackId); // Boxes after adjustRect, as drawn
+            ring.publish(record, frame);
+        }
+        frameIndex++; // Count the frame
+
         imshow("People detector", frame); // Show the frame in a window
 
         // Interact with the user
@@ -142,8 +196,17 @@ int main(int argc, char **argv)
         else if (key == ' ') // If the 'space' key is pressed
         {
             detector.toggleMode(); // Toggle the detection mode
+            change.reset(); // Run the new detector on the next frame even if the scene is static
         }
     }
 
+    ring.unlink(); // Remove the result ring, attached consumers keep their mapping
+
+    cout << "Processed frames: " << change.processedCount() << ", " << fixed << setprecision(1)
+         << (detectSeconds > 0 ? change.processedCount() / detectSeconds : 0.0) << " frames/second of detection" << endl;
+    if (change.enabled())
+        cout << "Change detector: " << change.skippedCount() << " static frames skipped ("
+             << setprecision(0) << 100.0 * change.skippedCount() / max(1L, change.processedCount() + change.skippedCount()) << "%)" << endl;
+
     return 0; // Return success code
 }
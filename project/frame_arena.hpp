@@ -0,0 +1,113 @@
+#ifndef FRAME_ARENA_HPP
+#define FRAME_ARENA_HPP
+
+#include <opencv2/core.hpp>  // Include for Mat, MatAllocator and the geometric types
+#include <atomic>            // Include for the process-wide allocation counter
+#include <cstddef>           // Include for size_t
+#include <vector>            // Include for the reusable line and slope vectors
+
+#include "lane_front_end.hpp"  // Include for the buffers of the colour mask, region of interest and Canny
+
+// Scratch images of the lane and detection stages, one buffer per slot
+enum ArenaSlot
+{
+    SLOT_LANE_INPUT,     // Reduced resolution copy of the frame for the lane stage
+    SLOT_LINE_IMG,       // Full resolution image the lane lines are drawn on
+    SLOT_DETECT_INPUT,   // Reduced resolution copy of the frame for the detectors
+    SLOT_COUNT
+};
+
+// Per-stream buffer pool for project/main.cpp, owned by the stream state.
+// Every stage takes its scratch images from here instead of creating new Mats, the buffers are
+// sized on the first frame and re-used afterwards, so at constant resolution the buffers the
+// pipeline owns (colour masks, region of interest, Canny input and edges, line image, reduced
+// detector input, Hough and lane fit vectors) are not reallocated. The OpenCV calls themselves
+// still allocate: HoughLinesP (accumulator, segment lists) and detectMultiScale (scale list,
+// candidates, pyramid Mats) on every call. Every (re)allocation of the arena is counted; the
+// allocations of the whole process are only reported as diagnostics by CountingMatAllocator and
+// the operator new counter of main.cpp.
+class FrameArena
+{
+public:
+    std::vector<cv::Vec4f> lines;  // Hough segments of the current frame
+    std::vector<float> rightSlope, leftSlope, rightIntercept, leftIntercept;  // Lane fit of the current frame
+    cv::Vec4f laneLines[2];  // Fitted lane lines of the current frame
+    int laneCount = 0;       // Valid entries of laneLines
+    LaneBuffers lane;        // Colour mask, region of interest and Canny buffers of the lane front end
+
+    FrameArena()
+    {
+        lines.reserve(256);  // Enough for a typical frame, larger frames grow once during the warm-up
+        rightSlope.reserve(128), leftSlope.reserve(128), rightIntercept.reserve(128), leftIntercept.reserve(128);
+    }
+
+    // Buffer of a slot with the requested size and type, fresh is set when the buffer was (re)allocated
+    cv::Mat &get(ArenaSlot slot, cv::Size size, int type, bool *fresh = nullptr)
+    {
+        cv::Mat &m = slots[slot];
+        bool realloc = m.empty() || m.size() != size || m.type() != type;
+        if (realloc)
+        {
+            m.create(size, type);
+            allocations++;
+        }
+        if (fresh)
+            *fresh = realloc;
+        return m;
+    }
+
+    // Count growth of the vectors, called once at the end of every frame
+    void endFrame()
+    {
+        size_t capacity = lines.capacity() + rightSlope.capacity() + leftSlope.capacity() +
+                          rightIntercept.capacity() + leftIntercept.capacity();
+        if (capacity != vectorCapacity)
+        {
+            vectorCapacity = capacity;
+            allocations++;
+        }
+        frames++;
+    }
+
+    size_t allocationCount() const { return allocations + lane.allocations; }  // Allocations since the arena was created
+    size_t frameCount() const { return frames; }            // Frames finished with endFrame
+
+private:
+    cv::Mat slots[SLOT_COUNT];  // One buffer per slot
+    size_t vectorCapacity = 0;  // Total capacity of the vectors after the last frame
+    size_t allocations = 0;     // Number of buffer (re)allocations
+    size_t frames = 0;          // Number of finished frames
+};
+
+// Default Mat allocator that counts every pixel buffer allocated by OpenCV, including the
+// temporary Mats inside HoughLinesP or detectMultiScale that the arena cannot see. The
+// buffers are allocated by the standard allocator, which also frees them. Install it with
+// cv::Mat::setDefaultAllocator before the first Mat is created.
+class CountingMatAllocator : public cv::MatAllocator
+{
+public:
+    CountingMatAllocator() : base(cv::Mat::getStdAllocator()) {}
+
+    cv::UMatData *allocate(int dims, const int *sizes, int type, void *data, size_t *step, cv::AccessFlag flags,
+                           cv::UMatUsageFlags usageFlags) const override
+    {
+        if (!data)
+            count.fetch_add(1, std::memory_order_relaxed);  // Mats wrapping user memory allocate no buffer
+        return base->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData *data, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return base->allocate(data, accessFlags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData *data) const override { base->deallocate(data); }
+
+    size_t allocationCount() const { return count.load(std::memory_order_relaxed); }  // Buffers allocated so far
+
+private:
+    cv::MatAllocator *base;                 // Standard allocator doing the work
+    mutable std::atomic<size_t> count{0};   // Buffers allocated by all threads
+};
+
+#endif // FRAME_ARENA_HPP
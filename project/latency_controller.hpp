@@ -0,0 +1,115 @@
+#ifndef LATENCY_CONTROLLER_HPP
+#define LATENCY_CONTROLLER_HPP
+
+#include <iostream>  // Include for logging every quality adjustment
+#include <iomanip>   // Include for formatting the log lines
+#include <vector>    // Include for the quality ladder
+
+// Knobs of the live pipeline that trade accuracy for time
+struct QualitySettings
+{
+    double detectScale;     // Scale of the image passed to detectMultiScale (1.0 = full resolution)
+    double scaleFactor;     // Scale factor between two detectMultiScale pyramid levels
+    int detectorSkip[3];    // Run pedestrian, car and traffic light detectors every n-th frame
+    double laneScale;       // Resolution of the lane detection stage (1.0 = full resolution)
+};
+
+// Per-frame deadline controller for project/main.cpp.
+// Keeps a smoothed frame time and walks a fixed quality ladder: one step down as soon as the
+// budget is exceeded for a few frames, one step up after a longer run of frames with headroom.
+// The asymmetric hysteresis keeps the pipeline from oscillating between two levels.
+class LatencyController
+{
+public:
+    // budgetMs <= 0 disables the controller, the pipeline then always runs at full quality
+    explicit LatencyController(double budgetMs = 0.0)
+        : budget(budgetMs), smoothed(0.0), level(0), overBudget(0), underBudget(0), frameIndex(0)
+    {
+        // Each level degrades one more knob than the previous one, cheapest quality loss first
+        ladder = {
+            {1.00, 1.10, {1, 1, 1}, 1.00},
+            {1.00, 1.15, {1, 1, 1}, 1.00},
+            {0.85, 1.15, {1, 1, 1}, 1.00},
+            {0.85, 1.15, {1, 1, 2}, 1.00},
+            {0.85, 1.15, {1, 1, 2}, 0.75},
+            {0.75, 1.20, {1, 1, 2}, 0.75},
+            {0.75, 1.20, {1, 2, 3}, 0.75},
+            {0.60, 1.20, {1, 2, 3}, 0.50},
+            {0.60, 1.30, {2, 2, 4}, 0.50},
+            {0.50, 1.30, {2, 3, 4}, 0.50},
+        };
+    }
+
+    // The tuned scale factor of the config becomes the full quality level, the degraded levels keep
+    // their distance to it (base, base + 0.05, base + 0.10, base + 0.20)
+    void setBaseScaleFactor(double scaleFactor)
+    {
+        if (scaleFactor <= 1.0)
+            return;  // detectMultiScale needs a factor above 1
+        double shift = scaleFactor - ladder[0].scaleFactor;
+        for (QualitySettings &q : ladder)
+            q.scaleFactor += shift;
+    }
+
+    bool enabled() const { return budget > 0.0; }
+    const QualitySettings &settings() const { return ladder[level]; }
+    int currentLevel() const { return level; }
+    double smoothedMs() const { return smoothed; }
+
+    // Feed the measured processing time of the frame that just finished
+    void update(double frameMs)
+    {
+        frameIndex++;
+        if (!enabled())
+            return;
+
+        smoothed = (smoothed == 0.0) ? frameMs : 0.8 * smoothed + 0.2 * frameMs;  // Exponential moving average
+
+        if (smoothed > budget)
+        {
+            underBudget = 0;
+            if (++overBudget >= degradeAfter && level + 1 < (int)ladder.size())
+                change(level + 1, "over");  // Behind the deadline: reduce quality
+        }
+        else if (smoothed < headroom * budget)
+        {
+            overBudget = 0;
+            if (++underBudget >= restoreAfter && level > 0)
+                change(level - 1, "under");  // Enough headroom: restore quality
+        }
+        else
+        {
+            overBudget = 0;  // Inside the band between headroom and budget, hold the level
+            underBudget = 0;
+        }
+    }
+
+private:
+    static constexpr int degradeAfter = 3;     // Frames over budget before stepping down
+    static constexpr int restoreAfter = 30;    // Frames with headroom before stepping up
+    static constexpr double headroom = 0.7;    // Fraction of the budget that counts as headroom
+
+    double budget;                        // Per-frame deadline in milliseconds
+    double smoothed;                      // Smoothed frame time in milliseconds
+    int level;                            // Current index into the ladder
+    int overBudget;                       // Consecutive frames over the budget
+    int underBudget;                      // Consecutive frames with headroom
+    long frameIndex;                      // Number of frames seen, used for the log
+    std::vector<QualitySettings> ladder;  // Quality levels from best to cheapest
+
+    // Switch to a new level and log the trade-off being made
+    void change(int newLevel, const char *direction)
+    {
+        const QualitySettings &q = ladder[newLevel];
+        std::cout << "[latency] frame " << frameIndex << ": " << std::fixed << std::setprecision(1) << smoothed
+                  << " ms " << direction << " " << budget << " ms budget, level " << level << " -> " << newLevel
+                  << std::setprecision(2) << " (detect scale " << q.detectScale << ", scale factor " << q.scaleFactor
+                  << ", skip " << q.detectorSkip[0] << "/" << q.detectorSkip[1] << "/" << q.detectorSkip[2]
+                  << ", lane scale " << q.laneScale << ")" << std::endl;
+        level = newLevel;
+        overBudget = 0;
+        underBudget = 0;
+    }
+};
+
+#endif // LATENCY_CONTROLLER_HPP
@@ -7,22 +7,51 @@
 #include <chrono>               // Include for time measurement operations
 #include <numeric>             // Include for numeric operations like accumulate for averaging
 #include <omp.h>               // Include for parallel processing with OpenMP
+#include <functional>          // Include for the stream tasks of the multi-stream mode
+#include <memory>              // Include for owning the streams of the multi-stream mode
+#include <thread>              // Include for the shard workers
+#include <fstream>             // Include for the record segments of the sharded mode
+#include <atomic>              // Include for the heap allocation counter
+#include <cstdlib>             // Include for malloc and free
+#include <new>                 // Include for bad_alloc
+
+#include "latency_controller.hpp"  // Per-frame deadline controller with adaptive quality
+#include "frame_arena.hpp"         // Per-stream scratch buffers, not reallocated in steady state
+#include "stream_scheduler.hpp"    // Work-stealing pool of the multi-stream mode
+#include "result_ring.hpp"         // Shared memory ring publishing the per-frame results
+#include "tuning_config.hpp"       // Parameters written by auto-tuner
+#include "thread_layout.hpp"       // Split of the threads over frames, detectors and OpenCV kernels
+#include "change_detector.hpp"     // Skips the pipeline while the scene does not change
+#include "video_shard.hpp"         // Splitting one long video into segments processed in parallel
+#include "detection_fusion.hpp"    // Grid-indexed suppression across detectors and track IDs
+#include "lane_front_end.hpp"      // Colour mask, region of interest and Canny of the lane stage
 
 using namespace std;  // Standard namespace for standard functions and types
 using namespace cv;   // OpenCV namespace for core OpenCV functions and types
 
-// Function to perform Canny edge detection
-Mat canny(Mat img)
+// With --assert-steady every operator new of the process is counted, so the report also shows the
+// vectors, strings and temporary buffers allocated inside OpenCV and the standard library. The
+// array and nothrow forms of the standard library call this one. Without the flag the counter is
+// never written, so the workers of the other modes do not share a contended cache line.
+static atomic<bool> heapCounting(false);
+static atomic<size_t> heapAllocations(0);
+
+void *operator new(size_t size)
 {
-    Mat gray_img;  // Create a matrix to hold the grayscale image
-    cvtColor(img, gray_img, COLOR_RGB2GRAY);  // Convert the input image from RGB to grayscale
-    Mat edges;  // Create a matrix to hold the edges detected by Canny
-    Canny(gray_img, edges, 110, 120);  // Apply Canny edge detection with specified thresholds
-    return edges;  // Return the edges detected in the image
-};
+    if (heapCounting.load(memory_order_relaxed))
+        heapAllocations.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1))
+        return p;
+    throw bad_alloc();
+}
+
+void operator delete(void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+
+static CountingMatAllocator matAllocator;  // Counts the pixel buffers of all Mats once installed
 
 // Function to calculate the average of a vector of floats
-float vectorAverage(vector<float> input_vec)
+float vectorAverage(const vector<float> &input_vec)
 {
     // Calculate the average of all elements in the vector
     float average = accumulate(input_vec.begin(), input_vec.end(), 0.0) / input_vec.size();
@@ -30,14 +59,16 @@ float vectorAverage(vector<float> input_vec)
 };
 
 // Function to draw lines on the image based on the detected lines
-void drawLines(Mat img, vector<Vec4f> lines, int thickness = 5)
+void drawLines(Mat &img, const vector<Vec4f> &lines, FrameArena &arena, int thickness = 5)
 {
     Scalar right_color = Scalar(0, 255, 0);  // Define the color for right lane lines (Green)
     Scalar left_color = Scalar(0, 255, 0);   // Define the color for left lane lines (Green)
-    vector<float> rightSlope, leftSlope, rightIntercept, leftIntercept;  // Vectors to store slopes and intercepts for each lane
+    vector<float> &rightSlope = arena.rightSlope, &leftSlope = arena.leftSlope;  // Vectors to store slopes for each lane
+    vector<float> &rightIntercept = arena.rightIntercept, &leftIntercept = arena.leftIntercept;  // Vectors to store intercepts for each lane
+    rightSlope.clear(), leftSlope.clear(), rightIntercept.clear(), leftIntercept.clear();  // Keep the capacity of the previous frames
 
     // Loop through each detected line
-    for (Vec4f line : lines)
+    for (const Vec4f &line : lines)
     {
         float x1 = line[0];  // Get the x-coordinate of the start point of the line
         float y1 = line[1];  // Get the y-coordinate of the start point of the line
@@ -88,75 +119,568 @@ void drawLines(Mat img, vector<Vec4f> lines, int thickness = 5)
     fillPoly(img, inner_shape, n_vertices, 1, Scalar(255, 0, 0), lineType);  // Fill the lane area with a blue color
     line(img, Point(left_line_x1, (int)round(0.65 * img.rows)), Point(left_line_x2, img.rows), left_color, thickness);  // Draw the left lane line
     line(img, Point(right_line_x1, (int)round(0.65 * img.rows)), Point(right_line_x2, img.rows), right_color, thickness);  // Draw the right lane line
+
+    // Keep the fitted lane lines (bottom point first) for the published results
+    arena.laneCount = 0;
+    if (!leftSlope.empty())
+        arena.laneLines[arena.laneCount++] = Vec4f((float)left_line_x2, (float)img.rows, (float)left_line_x1, (float)round(0.65 * img.rows));
+    if (!rightSlope.empty())
+        arena.laneLines[arena.laneCount++] = Vec4f((float)right_line_x2, (float)img.rows, (float)right_line_x1, (float)round(0.65 * img.rows));
 };
 
-// Function to perform Hough Line Transform and draw lines on a new image
-Mat hough_lines(Mat img, double rho, double theta, int threshold, double min_line_len, double max_line_gap)
+// Function to perform Hough Line Transform and draw lines on an arena image of size out_size
+// The lines are detected on img and scaled up when img is a reduced resolution copy of the frame
+Mat &hough_lines(const Mat &img, Size out_size, FrameArena &arena, double rho, double theta, int threshold, double min_line_len, double max_line_gap)
 {
-    vector<Vec4f> lines;  // Vector to store detected lines
-    Mat line_img(img.rows, img.cols, CV_8UC3, Scalar(0, 0, 0));  // Create an image to draw the detected lines
+    vector<Vec4f> &lines = arena.lines;  // Vector to store detected lines
+    Mat &line_img = arena.get(SLOT_LINE_IMG, out_size, CV_8UC3);  // Image to draw the detected lines
+    line_img.setTo(Scalar(0, 0, 0));  // Clear the lines of the previous frame
     HoughLinesP(img, lines, rho, theta, threshold, min_line_len, max_line_gap);  // Apply the Hough Line Transform to detect lines
 
-    drawLines(line_img, lines);  // Draw the detected lines on the image
+    float up = (float)out_size.width / img.cols;  // Factor from the detection resolution to the output resolution
+    if (up != 1.0f)
+    {
+        for (Vec4f &l : lines)
+            l *= up;  // Bring the end points back to full resolution so the lane filters keep their meaning
+    }
+
+    drawLines(line_img, lines, arena);  // Draw the detected lines on the image
     return line_img;  // Return the image with the drawn lines
 };
 
 // Function to perform line detection with default Hough Transform parameters
-Mat lineDetect(Mat img)
+Mat &lineDetect(const Mat &img, Size out_size, FrameArena &arena)
 {
-    return hough_lines(img, 1, CV_PI / 180, 50, 100, 100);  // Call hough_lines with default parameters for rho, theta, threshold, min_line_len, and max_line_gap
+    double scale = (double)img.cols / out_size.width;  // Resolution of img relative to the frame
+    // Call hough_lines with default parameters for rho, theta, threshold, min_line_len, and max_line_gap,
+    // the length dependent parameters are given at full resolution and scaled with the image
+    return hough_lines(img, out_size, arena, 1, CV_PI / 180, max(10, (int)round(50 * scale)), 100 * scale, 100 * scale);
 };
 
-// Function to blend two images together with specified weights
-Mat weighted_img(Mat img, Mat initial_img, double alpha = 0.8, double beta = 1.0, double gamma = 0.0)
+// Function to blend two images together with specified weights, dst may be initial_img
+void weighted_img(const Mat &img, const Mat &initial_img, Mat &dst, double alpha = 0.8, double beta = 1.0, double gamma = 0.0)
 {
-    Mat weighted_img;  // Create a matrix to store the resulting blended image
-    addWeighted(img, alpha, initial_img, beta, gamma, weighted_img);  // Perform the weighted sum of two images
-    return weighted_img;  // Return the blended image
+    addWeighted(img, alpha, initial_img, beta, gamma, dst);  // Perform the weighted sum of two images
 };
 
-// Function to perform lane detection on the source image
-Mat LaneDetection(Mat src)
+// Function to perform lane detection on the source image, the lane overlay is blended into src
+// scale < 1 runs the colour masks, Canny and Hough on a reduced resolution copy of the frame
+void LaneDetection(Mat &src, FrameArena &arena, const TuningConfig &tuning, double scale = 1.0)
 {
-    Mat color_masked, roi_img, canny_img, hough_img, final_img;  // Create matrices for various stages of processing
-    Mat hls, yellowmask, whitemask, maskN, masked;  // Create matrices for color space conversion and masks
-
-    cvtColor(src, hls, COLOR_RGB2HLS);  // Convert the source image from RGB to HLS color space
-    inRange(hls, Scalar(100, 0, 90), Scalar(50, 255, 255), yellowmask);  // Create a mask for detecting yellow colors
-    inRange(hls, Scalar(0, 70, 0), Scalar(255, 255, 255), whitemask);  // Create a mask for detecting white colors
-    bitwise_or(yellowmask, whitemask, maskN);  // Combine yellow and white masks using a bitwise OR operation
-    bitwise_and(src, src, masked, maskN = maskN);  // Apply the combined mask to the source image
-
-    int x = masked.cols;  // Get the width of the masked image
-    int y = masked.rows;  // Get the height of the masked image
-    Point polygon_vertices[1][4];  // Define the vertices of the polygon for the region of interest
-    polygon_vertices[0][0] = Point(0, y);  // Bottom left vertex of the polygon
-    polygon_vertices[0][1] = Point(x, y);  // Bottom right vertex of the polygon
-    polygon_vertices[0][2] = Point((int)round(0.55 * x), (int)round(0.6 * y));  // Top right vertex of the polygon
-    polygon_vertices[0][3] = Point((int)round(0.45 * x), (int)round(0.6 * y));  // Top left vertex of the polygon
-    const Point *polygons[1] = {polygon_vertices[0]};  // Create a pointer array for the polygon shape
-    int n_vertices[] = {4};  // Define the number of vertices for the polygon
-    Mat mask(y, x, CV_8UC1, Scalar(0));  // Create a mask for the region of interest
-    int lineType = LINE_8;  // Set the line type for drawing
-    fillPoly(mask, polygons, n_vertices, 1, Scalar(255, 255, 255), lineType);  // Fill the polygon area in the mask with white color
-    Mat masked_image;  // Create a matrix to hold the masked image
-    bitwise_and(masked, masked, masked_image, mask = mask);  // Apply the region of interest mask to the masked image
-    canny_img = canny(masked_image);  // Perform Canny edge detection on the masked image
-    hough_img = lineDetect(canny_img);  // Perform Hough Line Transform to detect lines
-    final_img = weighted_img(hough_img, src);  // Blend the Hough lines image with the original image
-    return final_img;  // Return the final image with lane markings
+    const Mat *work = &src;  // Image the lane stage works on
+    if (scale < 1.0)
+    {
+        Size reduced((int)round(src.cols * scale), (int)round(src.rows * scale));  // Resolution of the lane stage
+        Mat &small = arena.get(SLOT_LANE_INPUT, reduced, src.type());
+        resize(src, small, reduced, 0, 0, INTER_AREA);  // Reduce the resolution of the lane stage
+        work = &small;
+    }
+    Mat &canny_img = laneEdges(*work, arena.lane, tuning.cannyLow, tuning.cannyHigh);  // Colour mask, region of interest and Canny edge detection
+    Mat &hough_img = lineDetect(canny_img, src.size(), arena);  // Perform Hough Line Transform to detect lines
+    weighted_img(hough_img, src, src);  // Blend the Hough lines image into the original image
+};
+
+// Paths of the pedestrian, car and traffic light cascades, in the order of the detection results
+static const char *const CASCADE_FILES[3] = {"./xmlfile/pedetrian1.xml", "./xmlfile/carDetection.xml", "./xmlfile/traffic_light2.xml"};
+
+// Load the Haar Cascade classifier XML files for object detection
+bool loadDetectors(vector<CascadeClassifier> &detectors)
+{
+    detectors.resize(3);  // Pedestrian, car and traffic light detector
+    for (int i = 0; i < 3; ++i)
+    {
+        if (!detectors[i].load(CASCADE_FILES[i]))  // Load the detection XML file
+        {
+            cout << "Error: Unable to load " << CASCADE_FILES[i] << endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+// Load the parameters written by auto-tuner. Without --config the optional ./tuning.yml is used,
+// a config given explicitly has to exist
+bool loadTuning(TuningConfig &tuning, const string &path)
+{
+    if (path.empty())
+    {
+        if (tuning.load("tuning.yml"))
+            cout << "Loaded tuning.yml" << endl;
+        return true;
+    }
+    if (!tuning.load(path))
+    {
+        cout << "Error: Unable to read config " << path << endl;
+        return false;
+    }
+    cout << "Loaded " << path << endl;
+    return true;
+}
+
+// Pipeline state of one video stream
+struct StreamState
+{
+    FrameArena arena;                      // Scratch buffers of the lane and detection stages
+    LatencyController latency;             // Latency controller adjusting the quality to the per-frame deadline
+    vector<vector<Rect>> detection;        // Detected objects for each classifier, kept for skipped detectors
+    vector<vector<int>> neighbours;        // Neighbour count of every detected object, used as its score
+    vector<Detection> objects;             // Fused boxes of all classifiers with their track IDs
+    DetectionFusion fusion;                // Suppression and tracking state of the stream
+    long frameIndex = 0;                   // Index of the current frame, used by the detector skip rates
+    ResultRingWriter ring;                 // Optional shared memory publisher of the results
+    ResultRecord record;                   // Results of the current frame
+    TuningConfig tuning;                   // Canny thresholds and detector parameters
+    ChangeDetector change;                 // Decides whether the results of the previous frame still apply
+
+    explicit StreamState(double latencyBudget = 0.0, const TuningConfig &config = TuningConfig())
+        : latency(latencyBudget), detection(3), neighbours(3), tuning(config)
+    {
+        latency.setBaseScaleFactor(config.cascadeScaleFactor);  // Full quality runs at exactly the tuned scale factor
+    }
+};
+
+// Merge the boxes of the three detectors into one list, suppress duplicates and assign track IDs
+void fuseDetections(StreamState &st, Size frameSize)
+{
+    static const int32_t classes[3] = {RESULT_PEDESTRIAN, RESULT_CAR, RESULT_TRAFFIC_LIGHT};  // Class of every detector
+    st.objects.clear();
+    for (int i = 0; i < 3; ++i)  // Pedestrians first, they win ties against the other classes
+        for (size_t k = 0; k < st.detection[i].size(); ++k)
+        {
+            float score = k < st.neighbours[i].size() ? (float)st.neighbours[i][k] : 1.0f;  // Neighbour count of the box
+            st.objects.push_back({st.detection[i][k], classes[i], score});
+        }
+    st.fusion.apply(st.objects, frameSize);
+}
+
+// Draw the fused boxes with their track IDs into frame
+void drawDetections(Mat &frame, const StreamState &st)
+{
+    static const Scalar colours[3] = {Scalar(128, 0, 128), Scalar(0, 255, 255), Scalar(0, 0, 255)};  // Purple pedestrians, yellow cars, red traffic lights
+    for (const Detection &d : st.objects)  // Loop through the fused objects
+    {
+        rectangle(frame, d.box.tl(), d.box.br(), colours[d.cls], 2);  // Draw a rectangle in the colour of the class
+        putText(frame, to_string(d.trackId), Point(d.box.x, max(10, d.box.y - 4)), FONT_HERSHEY_SIMPLEX, 0.4, colours[d.cls], 1);  // Track ID above the box
+    }
+}
+
+// Run lane detection and the three detectors on frame and draw the results into it
+// The detectors run on the detector threads of the layout, the time of every stage is added to its report
+// A frame the change detector considers unchanged gets the lane overlay and boxes of the previous frame
+void processFrame(Mat &frame, StreamState &st, vector<CascadeClassifier> &detectors, ThreadLayout &layout)
+{
+    bool changed;
+    {
+        StageClock clock(layout, STAGE_DECODE);  // The change detector is part of the front end
+        changed = st.change.changed(frame);
+    }
+    if (!changed)
+    {
+        StageClock clock(layout, STAGE_OUTPUT);
+        bool fresh = false;
+        Mat &line_img = st.arena.get(SLOT_LINE_IMG, frame.size(), CV_8UC3, &fresh);  // Lane overlay of the last processed frame
+        if (fresh)
+            line_img.setTo(Scalar(0, 0, 0));  // No overlay at this resolution yet
+        weighted_img(line_img, frame, frame);  // Blend the carried lane overlay like LaneDetection does
+        drawDetections(frame, st);
+        st.frameIndex++;
+        st.arena.endFrame();
+        return;  // Lane lines and boxes in the arena and objects stay valid for publishing
+    }
+
+    int64 frameStart = getTickCount();  // Start of the processing of this frame
+    const QualitySettings &quality = st.latency.settings();  // Quality chosen by the latency controller
+
+    // Lane detection
+    {
+        StageClock clock(layout, STAGE_LANE);  // Lane stage runs on the calling thread
+        LaneDetection(frame, st.arena, st.tuning, quality.laneScale);  // Perform lane detection on the current frame
+    }
+
+    long long detectStart = ThreadLayout::clockNs(CLOCK_MONOTONIC);  // Wall time of the detector stage
+    const Mat *detectInput = &frame;  // Image the detectors run on
+    if (quality.detectScale < 1.0)
+    {
+        long long cpuStart = ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID);
+        Size reduced((int)round(frame.cols * quality.detectScale), (int)round(frame.rows * quality.detectScale));
+        Mat &small = st.arena.get(SLOT_DETECT_INPUT, reduced, frame.type());
+        resize(frame, small, reduced, 0, 0, INTER_AREA);  // Reduce the detection resolution
+        detectInput = &small;
+        layout.addCpu(STAGE_DETECT, ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID) - cpuStart);
+    }
+
+    // Parallelize the object detection over the detector threads of the layout
+    #pragma omp parallel for num_threads(layout.detectorThreads()) if (layout.detectorThreads() > 1)
+    for (int i = 0; i < 3; ++i)
+    {
+        if (st.frameIndex % quality.detectorSkip[i] != 0)
+            continue;  // Keep the previous result of a detector that is skipped on this frame
+        long long cpuStart = ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID);  // CPU time of this detector thread
+        detectors[i].detectMultiScale(*detectInput, st.detection[i], st.neighbours[i], quality.scaleFactor, st.tuning.cascadeMinNeighbors);  // Detect objects using each classifier, with their neighbour counts
+        if (quality.detectScale < 1.0)
+        {
+            for (Rect &r : st.detection[i])  // Bring the boxes back to full resolution
+                r = Rect(cvRound(r.x / quality.detectScale), cvRound(r.y / quality.detectScale),
+                         cvRound(r.width / quality.detectScale), cvRound(r.height / quality.detectScale));
+        }
+        layout.addCpu(STAGE_DETECT, ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID) - cpuStart);
+    }
+    long long fuseStart = ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID);
+    fuseDetections(st, frame.size());  // Boxes of skipped detectors take part as well and keep their IDs
+    layout.addCpu(STAGE_DETECT, ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID) - fuseStart);
+    layout.addWall(STAGE_DETECT, ThreadLayout::clockNs(CLOCK_MONOTONIC) - detectStart);
+    st.frameIndex++;
+
+    // Draw rectangles for detected objects
+    StageClock clock(layout, STAGE_OUTPUT);
+    drawDetections(frame, st);
+
+    st.latency.update(1000.0 * (getTickCount() - frameStart) / getTickFrequency());  // Feed the frame time to the latency controller
+    st.arena.endFrame();  // Account for vector growth of this frame
+};
+
+// Fill the record of the stream with the lane lines and boxes of the frame processed last
+void fillRecord(StreamState &st, double mediaTimeMs)
+{
+    ResultRecord &r = st.record;
+    r.clear();
+    r.frameIndex = (uint64_t)(st.frameIndex - 1);
+    r.mediaTimeMs = mediaTimeMs;
+    for (int i = 0; i < st.arena.laneCount; ++i)
+        r.addLane(st.arena.laneLines[i]);
+    for (const Detection &d : st.objects)
+        r.addBox(d.cls, d.box, d.trackId);
+};
+
+// Publish the lane lines and boxes of the frame processed last, and the frame itself when the ring carries frames
+void publishResults(StreamState &st, const Mat &frame, double mediaTimeMs)
+{
+    if (!st.ring.isOpened())
+        return;
+    fillRecord(st, mediaTimeMs);
+    st.ring.publish(st.record, frame);
+};
+
+// Create the result ring of a stream, frames are only carried with publishFrames
+bool openResultRing(StreamState &st, const string &name, bool publishFrames, const Mat &frame)
+{
+    if (st.ring.open(name, publishFrames ? 16 : 256, publishFrames ? frame.size() : Size(), frame.type()))
+        return true;
+    cout << "Error: Unable to create result ring " << name << endl;
+    return false;
+};
+
+// One input of the multi-stream mode
+struct Stream
+{
+    string source;             // File name or URL of the input
+    int id = 0;                // Index of the stream on the command line
+    VideoCapture cap;          // Decoder of the input, only touched by the worker running the stream
+    VideoWriter output;        // Optional writer of the processed frames
+    StreamState state;         // Pipeline state
+    Mat frame;                 // Frame buffer re-used by every read
+    double seconds = 0.0;      // Processing time of the stream
+    bool failed = false;       // The result ring of the stream could not be created
+
+    Stream(double latencyBudget, const TuningConfig &tuning) : state(latencyBudget, tuning) {}
 };
 
+// Process several inputs at once on a work-stealing pool of worker threads.
+// Every worker loads the cascades once and all streams it runs share them, so the model memory
+// grows with the number of workers instead of the number of streams.
+// With publishName, stream i publishes its results to the ring <publishName>_<i>
+int runMultiStream(const vector<string> &sources, int workers, const string &storePrefix, double latencyBudget,
+                   const string &publishName, bool publishFrames, const TuningConfig &tuning, ThreadLayout &layout,
+                   double skipThreshold, int maxSkip)
+{
+    vector<unique_ptr<Stream>> streams;  // All inputs, owned here and referenced by the tasks
+    for (size_t i = 0; i < sources.size(); ++i)
+    {
+        unique_ptr<Stream> st(new Stream(latencyBudget, tuning));
+        st->source = sources[i];
+        st->state.change.configure(skipThreshold, maxSkip);  // Optional static scene skipping
+        st->id = (int)i;
+        if (!st->cap.open(sources[i]))
+        {
+            cout << "Error: Unable to open " << sources[i] << endl;
+            return -1;
+        }
+        if (!storePrefix.empty())
+        {
+            Size frameSize((int)st->cap.get(CAP_PROP_FRAME_WIDTH), (int)st->cap.get(CAP_PROP_FRAME_HEIGHT));
+            st->output.open(storePrefix + to_string(i) + ".avi", VideoWriter::fourcc('M', 'J', 'P', 'G'), st->cap.get(CAP_PROP_FPS), frameSize, true);
+        }
+        streams.push_back(move(st));
+    }
+
+    vector<vector<CascadeClassifier>> workerDetectors(workers);  // Cascades of every worker
+    for (int w = 0; w < workers; ++w)
+        if (!loadDetectors(workerDetectors[w]))
+            return -1;
+
+    layout.apply();  // OpenMP and OpenCV thread counts of the layout
+    layout.describe(cout);
+
+    StreamScheduler scheduler(workers);
+    // A stream task processes one frame and queues itself again behind the other streams of the worker
+    function<void(Stream *, int)> step = [&](Stream *st, int worker) {
+        {
+            StageClock clock(layout, STAGE_DECODE);
+            if (!st->cap.read(st->frame))
+                return;  // End of this input, the task is not queued again
+        }
+        int64 t = getTickCount();
+        processFrame(st->frame, st->state, workerDetectors[worker], layout);
+        {
+            StageClock clock(layout, STAGE_OUTPUT);
+            if (!publishName.empty() && st->state.frameIndex == 1 &&
+                !openResultRing(st->state, publishName + "_" + to_string(st->id), publishFrames, st->frame))
+            {
+                st->failed = true;  // Stop the stream like the single stream mode, the other streams go on
+                return;
+            }
+            publishResults(st->state, st->frame, st->cap.get(CAP_PROP_POS_MSEC));
+            if (st->output.isOpened())
+                st->output.write(st->frame);
+        }
+        st->seconds += (getTickCount() - t) / getTickFrequency();
+        scheduler.submit(worker, [&step, st](int w) { step(st, w); });
+    };
+    for (size_t i = 0; i < streams.size(); ++i)
+    {
+        Stream *st = streams[i].get();
+        scheduler.submit((int)i, [&step, st](int w) { step(st, w); });  // Spread the streams over the workers
+    }
+
+    int64 start = getTickCount();
+    scheduler.start([&layout](int w) { layout.bindWorker(w); });  // Pin every worker to its cores
+    scheduler.wait();
+    double wall = (getTickCount() - start) / getTickFrequency();
+
+    long total = 0;  // Frames of all streams
+    bool failed = false;  // A stream stopped because its result ring could not be created
+    for (const unique_ptr<Stream> &st : streams)
+    {
+        st->state.ring.unlink();  // Clean shutdown, no segment is left in /dev/shm
+        failed = failed || st->failed;
+        total += st->state.frameIndex;
+        cout << "Stream " << st->source << ": " << st->state.frameIndex << " frames, "
+             << (st->seconds > 0 ? st->state.frameIndex / st->seconds : 0.0) << " frames/second";
+        if (st->state.change.enabled())
+            cout << ", " << st->state.change.skippedCount() << " static frames skipped";
+        cout << endl;
+    }
+    cout << "Total: " << total << " frames from " << streams.size() << " streams on " << workers << " workers in "
+         << wall << " s, " << (wall > 0 ? total / wall : 0.0) << " frames/second" << endl;
+    layout.report(cout);
+    return failed ? -1 : 0;
+}
+
+// Process one long video as consecutive shards in parallel, one thread and decoder per shard.
+// Every shard runs `overlap` frames before its first frame through the pipeline without emitting
+// them, so the latency controller, change detector and detector skip rates start with the history
+// a sequential run would have. Frames and records are written to per-shard segments and merged in
+// order at the end.
+int runSharded(const string &source, int shards, int overlap, const string &outputFileName, const string &recordsFileName,
+               double latencyBudget, const TuningConfig &tuning, ThreadLayout &layout, double skipThreshold, int maxSkip)
+{
+    VideoCapture probe(source);  // Only used for the frame count, rate and size
+    if (!probe.isOpened())
+    {
+        cout << "Error: Unable to open video file." << endl;
+        return -1;
+    }
+    long frameCount = (long)probe.get(CAP_PROP_FRAME_COUNT);
+    double fps = probe.get(CAP_PROP_FPS);
+    Size frameSize((int)probe.get(CAP_PROP_FRAME_WIDTH), (int)probe.get(CAP_PROP_FRAME_HEIGHT));
+    probe.release();
+
+    vector<VideoShard> plan = planShards(frameCount, shards, overlap);
+    vector<vector<CascadeClassifier>> shardDetectors(plan.size());  // Cascades of every shard thread
+    for (vector<CascadeClassifier> &d : shardDetectors)
+        if (!loadDetectors(d))
+            return -1;
+
+    layout.resolve((int)plan.size());
+    layout.setFrameWorkers((int)plan.size());  // One frame worker per shard, even with an explicit split
+    layout.apply();
+    layout.describe(cout);
+
+    vector<string> videoSegments, recordSegments;  // Temporary outputs of the shards
+    for (const VideoShard &shard : plan)
+    {
+        videoSegments.push_back(shardSegmentName(outputFileName, shard.index, ".avi"));
+        recordSegments.push_back(shardSegmentName(recordsFileName, shard.index, ".csv"));
+    }
+    vector<long> emitted(plan.size(), 0);  // Frames written by every shard
+    vector<int> failed(plan.size(), 0);    // Shards whose decoder could not be positioned
+
+    int64 start = getTickCount();
+    vector<thread> threads;
+    for (size_t s = 0; s < plan.size(); ++s)
+    {
+        threads.emplace_back([&, s]() {
+            layout.bindWorker((int)s);
+            const VideoShard &shard = plan[s];
+            VideoCapture cap;
+            if (!openShard(cap, source, shard, fps))
+            {
+                failed[s] = 1;
+                return;
+            }
+            StreamState state(latencyBudget, tuning);  // Pipeline state of this shard
+            state.change.configure(skipThreshold, maxSkip);
+            state.fusion.setFirstId(shard.index * 1000000);  // Track IDs of different shards never collide
+            VideoWriter output;
+            ofstream records;
+            if (!outputFileName.empty())
+                output.open(videoSegments[s], VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, frameSize, true);
+            if (!recordsFileName.empty())
+                records.open(recordSegments[s]);
+            Mat frame;
+            for (long position = shard.warmupBegin; position < shard.end; ++position)
+            {
+                {
+                    StageClock clock(layout, STAGE_DECODE);
+                    if (!cap.read(frame))
+                        break;  // End of the video
+                }
+                processFrame(frame, state, shardDetectors[s], layout);
+                if (position < shard.begin)
+                    continue;  // Warm-up frame, only there for the history of the pipeline
+                StageClock clock(layout, STAGE_OUTPUT);
+                if (output.isOpened())
+                    output.write(frame);
+                if (records.is_open())
+                {
+                    fillRecord(state, fps > 0 ? 1000.0 * position / fps : -1.0);
+                    state.record.frameIndex = (uint64_t)position;  // Index in the whole video, not in the shard
+                    appendRecordCsv(records, state.record);
+                }
+                emitted[s]++;
+            }
+        });
+    }
+    for (thread &t : threads)
+        t.join();
+    double wall = (getTickCount() - start) / getTickFrequency();  // Parallel processing of the shards
+
+    long total = 0;  // Frames emitted by all shards
+    for (size_t s = 0; s < plan.size(); ++s)
+    {
+        if (failed[s])
+        {
+            cout << "Error: Unable to seek shard " << s << " to frame " << plan[s].warmupBegin << endl;
+            return -1;
+        }
+        total += emitted[s];
+        cout << "Shard " << s << ": frames " << plan[s].begin << " to " << plan[s].begin + emitted[s] - 1 << ", "
+             << plan[s].begin - plan[s].warmupBegin << " warm-up frames" << endl;
+    }
+
+    int64 mergeStart = getTickCount();  // The merge re-encodes the whole video on one thread
+    if (!outputFileName.empty() && !mergeVideoSegments(videoSegments, outputFileName, fps, frameSize))
+    {
+        cout << "Error: Unable to merge the video segments into " << outputFileName << endl;
+        return -1;
+    }
+    if (!recordsFileName.empty() && !mergeRecordSegments(recordSegments, recordsFileName))
+    {
+        cout << "Error: Unable to merge the record segments into " << recordsFileName << endl;
+        return -1;
+    }
+    double merge = (getTickCount() - mergeStart) / getTickFrequency();
+    cout << "Total: " << total << " frames in " << plan.size() << " shards, processing " << wall << " s ("
+         << (wall > 0 ? total / wall : 0.0) << " frames/second), merge " << merge << " s, end to end "
+         << (wall + merge > 0 ? total / (wall + merge) : 0.0) << " frames/second" << endl;
+    layout.report(cout);
+    return 0;
+}
+
 // Main function to handle video processing and feature detection
 int main(int argc, char *argv[])
 {
     // Check for the correct number of command line arguments
     if (argc < 2)
     {
-        cout << "Usage: " << argv[0] << " <video_file_name> [--show] [--store <output_file_name>]" << endl;
+        cout << "Usage: " << argv[0] << " <video_file_name> [--show] [--store <output_file_name>] [--budget <ms_per_frame>] [--assert-steady <warmup_frames>] [--publish <ring_name> [--publish-frames]] [--config <tuning.yml>] [--threads <spec>] [--pin none|compact|numa] [--skip-static <threshold> [--max-skip <n>]]" << endl;
+        cout << "       " << argv[0] << " <video_file_name> --shards <n> [--overlap <frames>] [--store <output_file_name>] [--records <records.csv>] [--budget <ms_per_frame>] [--config <tuning.yml>] [--threads <spec>] [--pin none|compact|numa] [--skip-static <threshold> [--max-skip <n>]]" << endl;
+        cout << "       " << argv[0] << " --multi <video_1> <video_2> ... [--workers <n>] [--store-prefix <prefix>] [--budget <ms_per_frame>] [--publish <ring_name> [--publish-frames]] [--config <tuning.yml>] [--threads <spec>] [--pin none|compact|numa] [--skip-static <threshold> [--max-skip <n>]]" << endl;
+        cout << "       <spec> = auto | <total> | <total>:<frame>:<detector>:<kernel>" << endl;
         return -1;  // Exit if there are not enough arguments
     }
 
+    // Multi-stream mode, every input is processed concurrently on a shared pool of workers
+    if (string(argv[1]) == "--multi")
+    {
+        vector<string> sources;  // Inputs of the streams
+        int workers = 0;  // Frame workers, 0 takes the frame threads of the layout
+        string storePrefix;  // Output files are <prefix><stream index>.avi
+        double latencyBudget = 0.0;  // Per-frame deadline of every stream
+        string publishName;  // Stream i publishes to the shared memory ring <name>_<i>
+        bool publishFrames = false;  // Publish the processed frames next to the results
+        string configPath;  // Tuning config given on the command line
+        ThreadLayout layout;  // Threads of the frame, detector and kernel level
+        double skipThreshold = 0.0;  // Block difference below which a frame reuses the previous results, 0 disables
+        int maxSkip = 30;  // Frames skipped in a row before one is processed anyway
+        for (int i = 2; i < argc; ++i)
+        {
+            string arg = argv[i];
+            if (arg == "--workers" && i + 1 < argc)
+                workers = atoi(argv[++i]);
+            else if (arg == "--store-prefix" && i + 1 < argc)
+                storePrefix = argv[++i];
+            else if (arg == "--budget" && i + 1 < argc)
+                latencyBudget = atof(argv[++i]);
+            else if (arg == "--publish" && i + 1 < argc)
+                publishName = argv[++i];
+            else if (arg == "--publish-frames")
+                publishFrames = true;
+            else if (arg == "--config" && i + 1 < argc)
+                configPath = argv[++i];
+            else if (arg == "--threads" && i + 1 < argc)
+            {
+                if (!layout.parse(argv[++i]))
+                {
+                    cout << "Error: Invalid thread layout '" << argv[i] << "', use auto, <total> or <total>:<frame>:<detector>:<kernel> with frame * detector + kernel - 1 <= total." << endl;
+                    return -1;
+                }
+            }
+            else if (arg == "--skip-static" && i + 1 < argc)
+                skipThreshold = atof(argv[++i]);
+            else if (arg == "--max-skip" && i + 1 < argc)
+                maxSkip = atoi(argv[++i]);
+            else if (arg == "--pin" && i + 1 < argc)
+            {
+                if (!layout.setPlacement(argv[++i]))
+                {
+                    cout << "Error: Invalid placement '" << argv[i] << "', use none, compact or numa." << endl;
+                    return -1;
+                }
+            }
+            else if (arg.compare(0, 2, "--") == 0)
+            {
+                cout << "Error: Unknown argument '" << arg << "'." << endl;
+                return -1;
+            }
+            else
+                sources.push_back(arg);
+        }
+        if (sources.empty())
+        {
+            cout << "Error: No input streams given." << endl;
+            return -1;
+        }
+        TuningConfig tuning;  // Parameters of every stream
+        if (!loadTuning(tuning, configPath))
+            return -1;
+        layout.resolve((int)sources.size());
+        if (workers <= 0)
+            workers = layout.frameThreads();  // --workers overrides the frame level of the layout
+        layout.setFrameWorkers(workers);  // Kernel pool sized for the workers that really run
+        return runMultiStream(sources, workers, storePrefix, latencyBudget, publishName, publishFrames, tuning, layout, skipThreshold, maxSkip);
+    }
+
     // Load the video file
     VideoCapture cap(argv[1]);  // Open the video file specified by the command line argument
 
@@ -166,85 +690,164 @@ int main(int argc, char *argv[])
         return -1;  // Exit if the video file cannot be opened
     }
 
-    // Create a window for displaying intermediate results if --show flag is provided
+    // Parse the optional flags
     bool showIntermediate = false;  // Flag to indicate if intermediate results should be shown
     string intermediateWindowName = "Intermediate Results";  // Name of the window for intermediate results
-    if (argc > 2 && string(argv[2]) == "--show")
+    bool storeResults = false;  // Flag to indicate if results should be saved to a file
+    string outputFileName;  // Variable to store the output file name
+    double latencyBudget = 0.0;  // Per-frame deadline in milliseconds, 0 disables the latency controller
+    int warmupFrames = -1;  // Frames after which the frame arena must not allocate, negative disables the check
+    string publishName;  // Name of the shared memory result ring, empty disables publishing
+    bool publishFrames = false;  // Publish the processed frames next to the results
+    string configPath;  // Tuning config given on the command line
+    ThreadLayout layout;  // Threads of the detector and kernel level
+    double skipThreshold = 0.0;  // Block difference below which a frame reuses the previous results, 0 disables
+    int maxSkip = 30;  // Frames skipped in a row before one is processed anyway
+    int shards = 1;  // Segments of the video processed in parallel
+    int overlap = 30;  // Warm-up frames of every shard
+    string recordsFileName;  // Per-frame lane lines and boxes of the sharded mode
+    for (int i = 2; i < argc; ++i)
     {
-        showIntermediate = true;  // Set the flag to show intermediate results
-        namedWindow(intermediateWindowName, WINDOW_AUTOSIZE);  // Create a window for displaying intermediate results
+        string arg = argv[i];
+        if (arg == "--show")
+            showIntermediate = true;  // Set the flag to show intermediate results
+        else if (arg == "--store" && i + 1 < argc)
+        {
+            storeResults = true;  // Set the flag to store results
+            outputFileName = argv[++i];  // Get the output file name from command line arguments
+        }
+        else if (arg == "--budget" && i + 1 < argc)
+            latencyBudget = atof(argv[++i]);  // Get the per-frame deadline from command line arguments
+        else if (arg == "--publish" && i + 1 < argc)
+            publishName = argv[++i];  // Publish the results to this shared memory ring
+        else if (arg == "--publish-frames")
+            publishFrames = true;  // Publish the processed frames next to the results
+        else if (arg == "--assert-steady" && i + 1 < argc)
+            warmupFrames = atoi(argv[++i]);  // Fail if the frame arena allocates after this many frames
+        else if (arg == "--config" && i + 1 < argc)
+            configPath = argv[++i];  // Load the tuned parameters from this file
+        else if (arg == "--skip-static" && i + 1 < argc)
+            skipThreshold = atof(argv[++i]);  // Reuse the results while the scene does not change
+        else if (arg == "--max-skip" && i + 1 < argc)
+            maxSkip = atoi(argv[++i]);  // Process at least every n-th frame
+        else if (arg == "--shards" && i + 1 < argc)
+            shards = max(1, atoi(argv[++i]));  // Process the video as this many segments in parallel
+        else if (arg == "--overlap" && i + 1 < argc)
+            overlap = max(0, atoi(argv[++i]));  // Warm-up frames decoded before every segment
+        else if (arg == "--records" && i + 1 < argc)
+            recordsFileName = argv[++i];  // Write the lane lines and boxes of every frame to this file
+        else if (arg == "--threads" && i + 1 < argc)
+        {
+            if (!layout.parse(argv[++i]))  // Thread layout of the detector and kernel level
+            {
+                cout << "Error: Invalid thread layout '" << argv[i] << "', use auto, <total> or <total>:<frame>:<detector>:<kernel> with frame * detector + kernel - 1 <= total." << endl;
+                return -1;
+            }
+        }
+        else if (arg == "--pin" && i + 1 < argc)
+        {
+            if (!layout.setPlacement(argv[++i]))  // Pin the pipeline to its cores
+            {
+                cout << "Error: Invalid placement '" << argv[i] << "', use none, compact or numa." << endl;
+                return -1;
+            }
+        }
+        else
+        {
+            cout << "Error: Unknown argument '" << arg << "'." << endl;
+            return -1;  // Exit on unknown arguments
+        }
+    }
+
+    TuningConfig tuning;  // Canny thresholds and detector parameters
+    if (!loadTuning(tuning, configPath))
+        return -1;  // Exit if the requested config cannot be read
+
+    // Sharded mode, the segments are processed without a window and merged at the end
+    if (shards > 1 || !recordsFileName.empty())
+    {
+        if (showIntermediate || !publishName.empty() || warmupFrames >= 0)
+        {
+            cout << "Error: --show, --publish and --assert-steady are not available with --shards or --records." << endl;
+            return -1;
+        }
+        cap.release();  // Every shard opens its own decoder
+        return runSharded(argv[1], shards, overlap, outputFileName, recordsFileName, latencyBudget, tuning, layout, skipThreshold, maxSkip);
     }
 
+    // Create a window for displaying intermediate results if --show flag is provided
+    if (showIntermediate)
+        namedWindow(intermediateWindowName, WINDOW_AUTOSIZE);  // Create a window for displaying intermediate results
+
     // Create a video writer if --store flag is provided
-    bool storeResults = false;  // Flag to indicate if results should be saved to a file
     VideoWriter outputVideo;  // VideoWriter object for saving the processed video
-    string outputFileName;  // Variable to store the output file name
-    if (argc > 3 && string(argv[3]) == "--store" && argc > 4)
+    if (storeResults)
     {
-        storeResults = true;  // Set the flag to store results
-        outputFileName = argv[4];  // Get the output file name from command line arguments
         int codec = VideoWriter::fourcc('M', 'J', 'P', 'G');  // Define the codec for video writing
         Size frameSize = Size((int)cap.get(CAP_PROP_FRAME_WIDTH), (int)cap.get(CAP_PROP_FRAME_HEIGHT));  // Get the frame size of the video
         outputVideo.open(outputFileName, codec, cap.get(CAP_PROP_FPS), frameSize, true);  // Open the video writer with the specified codec and frame size
     }
 
+    StreamState stream(latencyBudget, tuning);  // Lane, detection and latency state of the video
+    stream.change.configure(skipThreshold, maxSkip);  // Optional static scene skipping
+    if (stream.latency.enabled())
+        cout << "Latency budget: " << latencyBudget << " ms per frame" << endl;
+
     bool showNormalFrames = false;  // Flag to indicate if normal frames or processed frames should be shown
     cout << "Press space to turn on or turn off the features." << endl;  // Inform the user about the space bar functionality
 
-    // Load the Haar Cascade classifier XML files for object detection
-    CascadeClassifier pedestrianDetector;  // Create a CascadeClassifier object for pedestrian detection
-    pedestrianDetector.load("./xmlfile/pedestrian1.xml");  // Load the pedestrian detection XML file
-
-    CascadeClassifier carDetector;  // Create a CascadeClassifier object for car detection
-    carDetector.load("./xmlfile/carDetection.xml");  // Load the car detection XML file
-
-    CascadeClassifier trafficLightDetector;  // Create a CascadeClassifier object for traffic light detection
-    trafficLightDetector.load("./xmlfile/traffic_light2.xml");  // Load the traffic light detection XML file
+    // Classifier array
+    vector<CascadeClassifier> detectors;  // Pedestrian, car and traffic light detectors
+    if (!loadDetectors(detectors))
+        return -1;  // Exit if a cascade cannot be loaded
 
     // Framerate calculation
     auto start = std::chrono::steady_clock::now();  // Get the current time for calculating frame rate
     int fps = 0;  // Counter for frames per second
     int currentFps = 1;  // Variable to store the current frames per second value
 
-    // Classifier array
-    vector<CascadeClassifier> detectors = {pedestrianDetector, carDetector, trafficLightDetector};  // Store all the detectors in a vector
-
     // Process each frame of the video
     Mat frame;  // Matrix to store the current frame of the video
-    while (cap.read(frame))  // Read frames from the video file
+    FrameArena &arena = stream.arena;  // Scratch buffers of the lane and detection stages
+    size_t warmupAllocations = 0;  // Arena allocations at the end of the warm-up
+    size_t steadyHeap = 0, steadyMats = 0;  // Heap and Mat allocations of the pipeline after the warm-up
+    if (warmupFrames >= 0)
+    {
+        Mat::setDefaultAllocator(&matAllocator);  // Count the Mat buffers allocated anywhere in OpenCV
+        heapCounting.store(true, memory_order_relaxed);
+    }
+    layout.resolve(1);  // Single stream: all threads go to the detector and kernel level
+    layout.apply();
+    layout.bindWorker(0);  // The main thread is the only frame worker
+    layout.describe(cout);
+    while (true)
     {
-        // Lane detection
-        frame = LaneDetection(frame);  // Perform lane detection on the current frame
-
-        vector<vector<Rect>> detection(3);  // Vector to store detected objects for each classifier
-
-        #pragma omp parallel for  // Parallelize the object detection to improve performance
-        for (int i = 0; i < 3; ++i)
-        {
-            detectors[i].detectMultiScale(frame, detection[i], 1.1, 2);  // Detect objects using each classifier
-        }
-
-        // Draw rectangles for detected objects
-
-        for (const auto &rect : detection[2])  // Loop through detected traffic lights
         {
-            rectangle(frame, rect.tl(), rect.br(), Scalar(0, 0, 255), 2);  // Draw red rectangles around detected traffic lights
+            StageClock clock(layout, STAGE_DECODE);
+            if (!cap.read(frame))  // Read frames from the video file
+                break;
         }
-
-        for (const auto &rect : detection[1])  // Loop through detected cars
+        size_t heapBefore = heapAllocations.load(memory_order_relaxed), matsBefore = matAllocator.allocationCount();
+        processFrame(frame, stream, detectors, layout);  // Lane detection, object detection and drawing
         {
-            rectangle(frame, rect.tl(), rect.br(), Scalar(0, 255, 255), 2);  // Draw yellow rectangles around detected cars
-        }
+            StageClock clock(layout, STAGE_OUTPUT);
+            if (!publishName.empty() && stream.frameIndex == 1 && !openResultRing(stream, publishName, publishFrames, frame))
+                return -1;  // Exit if the result ring cannot be created
+            publishResults(stream, frame, cap.get(CAP_PROP_POS_MSEC));  // Hand the results to downstream consumers
+            if (warmupFrames >= 0 && (long)arena.frameCount() > warmupFrames)  // Pipeline allocations, without the encoder and the window
+            {
+                steadyHeap += heapAllocations.load(memory_order_relaxed) - heapBefore;
+                steadyMats += matAllocator.allocationCount() - matsBefore;
+            }
 
-        for (const auto &rect : detection[0])  // Loop through detected pedestrians
-        {
-            rectangle(frame, rect.tl(), rect.br(), Scalar(128, 0, 128), 2);  // Draw purple rectangles around detected pedestrians
+            if (storeResults)  // Check if results should be saved
+            {
+                outputVideo.write(frame);  // Write the processed frame to the output video file
+            }
         }
 
-        if (storeResults)  // Check if results should be saved
-        {
-            outputVideo.write(frame);  // Write the processed frame to the output video file
-        }
+        if ((long)arena.frameCount() == warmupFrames)
+            warmupAllocations = arena.allocationCount();  // Everything after this point is steady state
 
         auto now = std::chrono::steady_clock::now();  // Get the current time for calculating frame rate
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(now - start).count();  // Calculate the elapsed time in seconds
@@ -261,6 +864,7 @@ int main(int argc, char *argv[])
         if (key == 27 || key == 'q')  // Check if the escape key or 'q' key is pressed
         {
             cout << "Exit requested" << endl;  // Inform the user that the program is exiting
+            stream.ring.unlink();  // Remove the result ring, attached consumers keep their mapping
             cap.release();  // Release the video capture object
             if (storeResults)
                 outputVideo.release();  // Release the video writer object if results are being saved
@@ -283,4 +887,21 @@ int main(int argc, char *argv[])
             }
         }
     }
+
+    stream.ring.unlink();  // Remove the result ring, attached consumers keep their mapping
+    layout.report(cout);
+    if (stream.change.enabled())
+        cout << "Change detector: " << stream.change.processedCount() << " frames processed, "
+             << stream.change.skippedCount() << " static frames skipped" << endl;
+    cout << "Frame arena: " << arena.allocationCount() << " allocations in " << arena.frameCount() << " frames" << endl;
+    if (warmupFrames >= 0)
+    {
+        size_t steady = arena.allocationCount() - warmupAllocations;  // Allocations after the warm-up
+        cout << "Frame arena: " << steady << " allocations after " << warmupFrames << " warm-up frames" << endl;
+        cout << "Inside OpenCV and the standard library (diagnostic): " << steadyMats << " Mat buffer and "
+             << steadyHeap << " heap allocations after the warm-up" << endl;
+        if (steady > 0 || (long)arena.frameCount() <= warmupFrames)
+            return 1;  // The pipeline buffers were reallocated or the steady state was never reached
+    }
+    return 0;
 }
@@ -0,0 +1,129 @@
+#ifndef STREAM_SCHEDULER_HPP
+#define STREAM_SCHEDULER_HPP
+
+#include <atomic>              // Include for the pending task counter
+#include <chrono>              // Include for the idle wait timeout
+#include <condition_variable>  // Include for parking idle workers
+#include <deque>               // Include for the per-worker task queues
+#include <functional>          // Include for the task type
+#include <memory>              // Include for the per-worker queue objects
+#include <mutex>               // Include for guarding the queues
+#include <thread>              // Include for the worker threads
+#include <vector>              // Include for the worker list
+
+// Work-stealing pool used by the multi-stream mode of project/main.cpp.
+// Every worker owns a queue, takes tasks from its front and, when it runs dry, steals from the
+// back of another worker's queue. A stream task handles one frame and then re-submits itself to
+// the back of the queue of the worker that ran it, so streams sharing a worker take turns frame by
+// frame (fairness) and a stream never has more than one frame in flight (backpressure: a source
+// is only read when a worker is ready for it).
+class StreamScheduler
+{
+public:
+    typedef std::function<void(int)> Task;  // Task receiving the index of the worker running it
+
+    explicit StreamScheduler(int workers)
+    {
+        if (workers < 1)
+            workers = 1;
+        for (int i = 0; i < workers; ++i)
+            queues.emplace_back(new WorkerQueue());
+    }
+
+    ~StreamScheduler() { wait(); }
+
+    int workerCount() const { return (int)queues.size(); }
+
+    // Queue a task on a worker, usable from inside a running task to continue a stream
+    void submit(int worker, Task task)
+    {
+        pending++;
+        {
+            std::lock_guard<std::mutex> lock(queues[worker % queues.size()]->mutex);
+            queues[worker % queues.size()]->tasks.push_back(std::move(task));
+        }
+        wake.notify_one();
+    }
+
+    // Start the workers; onStart runs first in every worker thread (pinning, thread-local setup)
+    void start(std::function<void(int)> onStart = nullptr)
+    {
+        for (int i = 0; i < (int)queues.size(); ++i)
+        {
+            threads.emplace_back([this, i, onStart]() {
+                if (onStart)
+                    onStart(i);
+                run(i);
+            });
+        }
+    }
+
+    // Block until every task, including re-submitted ones, has finished
+    void wait()
+    {
+        for (std::thread &t : threads)
+            t.join();
+        threads.clear();
+    }
+
+private:
+    struct WorkerQueue
+    {
+        std::mutex mutex;       // Guards tasks
+        std::deque<Task> tasks; // Owner pops the front, thieves take the back
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;  // One queue per worker
+    std::vector<std::thread> threads;                  // Worker threads
+    std::atomic<int> pending{0};                       // Tasks queued or running
+    std::mutex wakeMutex;                              // Guards the idle wait
+    std::condition_variable wake;                      // Signalled on submit and when the pool drains
+
+    // Take a task from the own queue first, then steal from the others
+    bool take(int self, Task &task)
+    {
+        int n = (int)queues.size();
+        for (int k = 0; k < n; ++k)
+        {
+            WorkerQueue &q = *queues[(self + k) % n];
+            std::lock_guard<std::mutex> lock(q.mutex);
+            if (q.tasks.empty())
+                continue;
+            if (k == 0)
+            {
+                task = std::move(q.tasks.front());
+                q.tasks.pop_front();
+            }
+            else
+            {
+                task = std::move(q.tasks.back());
+                q.tasks.pop_back();
+            }
+            return true;
+        }
+        return false;
+    }
+
+    // Worker loop, exits once no task is queued or running anywhere
+    void run(int self)
+    {
+        while (true)
+        {
+            Task task;
+            if (take(self, task))
+            {
+                task(self);
+                if (--pending == 0)
+                    wake.notify_all();  // Let the idle workers see that the pool drained
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(wakeMutex);
+            if (pending == 0)
+                return;
+            wake.wait_for(lock, std::chrono::milliseconds(1));  // Short wait, a submit may race with the check
+        }
+    }
+};
+
+#endif // STREAM_SCHEDULER_HPP
@@ -0,0 +1,309 @@
+#ifndef THREAD_LAYOUT_HPP
+#define THREAD_LAYOUT_HPP
+
+#include <opencv2/core.hpp>  // Include for setNumThreads
+#include <omp.h>             // Include for the OpenMP thread controls
+#include <pthread.h>         // Include for pinning threads to cores
+#include <sched.h>           // Include for the CPU sets
+#include <time.h>            // Include for the thread and process CPU clocks
+#include <atomic>            // Include for the per-stage counters
+#include <cstdio>            // Include for sscanf
+#include <dirent.h>          // Include for listing the NUMA nodes
+#include <fstream>           // Include for reading the NUMA topology
+#include <iomanip>           // Include for formatting the report
+#include <iostream>          // Include for the report
+#include <sstream>           // Include for parsing CPU lists
+#include <string>            // Include for the layout spec
+#include <vector>            // Include for the CPU lists
+#include <algorithm>         // Include for find, max and min
+
+// Stages of project/main.cpp measured by the utilisation report
+enum PipelineStage
+{
+    STAGE_DECODE,   // Reading the next frame
+    STAGE_LANE,     // Lane detection
+    STAGE_DETECT,   // Cascade detectors
+    STAGE_OUTPUT,   // Drawing, publishing and writing the frame
+    STAGE_COUNT
+};
+
+// Single owner of the threads of project/main.cpp. The threads are split over three levels:
+//   frame     workers processing frames of different streams concurrently
+//   detector  OpenMP threads running the three cascades of one frame concurrently
+//   kernel    OpenCV threads inside a single call (cvtColor, Canny, detectMultiScale, ...)
+// The kernel threads are one process-wide OpenCV pool. OpenCV only suppresses nested parallel
+// loops through a process-wide flag, not per caller, so a cascade running on a detector thread
+// still fans out to the pool: the pool adds kernel - 1 threads to whatever the workers run, and the
+// layout needs frame * detector + kernel - 1 cores. The pool is sized once in apply() from the
+// number of frame workers that really run, so the detector threads keep their own cores and no
+// thread resizes the pool while frames are processed. Every worker can be pinned to its own block
+// of cores; the OpenMP threads it starts inherit the block. With NUMA placement the blocks of
+// consecutive workers alternate between the nodes and never straddle two nodes, so the scratch
+// buffers a worker touches first stay on its node.
+class ThreadLayout
+{
+public:
+    enum Placement { PLACE_NONE, PLACE_COMPACT, PLACE_NUMA };
+
+    ThreadLayout() : total(0), frame(0), detector(0), kernel(0), placement(PLACE_NONE), explicitSplit(false)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)  // Cores this process may run on (taskset, cgroups)
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &set))
+                    cpus.push_back(c);
+        if (cpus.empty())
+            cpus.push_back(0);
+        for (int s = 0; s < STAGE_COUNT; ++s)
+            wallNs[s] = cpuNs[s] = 0;
+    }
+
+    // "auto", "<total>" or "<total>:<frame>:<detector>:<kernel>"
+    bool parse(const std::string &spec)
+    {
+        if (spec == "auto")
+            return true;
+        int t = 0, f = 0, d = 0, k = 0;
+        int n = sscanf(spec.c_str(), "%d:%d:%d:%d", &t, &f, &d, &k);
+        if (n == 1 && t > 0)
+        {
+            total = t;
+            return true;
+        }
+        if (n != 4 || t < 1 || f < 1 || d < 1 || k < 1 || f * std::min(d, 3) + k - 1 > t)
+            return false;  // Malformed or more threads than the total
+        total = t, frame = f, detector = std::min(d, 3), kernel = k;
+        explicitSplit = true;
+        return true;
+    }
+
+    bool setPlacement(const std::string &mode)
+    {
+        if (mode == "none")
+            placement = PLACE_NONE;
+        else if (mode == "compact")
+            placement = PLACE_COMPACT;
+        else if (mode == "numa")
+            placement = PLACE_NUMA;
+        else
+            return false;
+        return true;
+    }
+
+    // Derive the split for a number of streams unless it was given explicitly.
+    // One stream: up to three detector threads and the remaining cores plus the calling thread to
+    // the kernel pool. Several streams: one worker per stream up to the number of cores, the rest
+    // to the detectors, and single threaded kernels as OpenCV only runs one parallel loop at a time
+    // across the process.
+    void resolve(int streams)
+    {
+        if (total <= 0)
+            total = (int)cpus.size();
+        if (!explicitSplit)
+        {
+            frame = std::max(1, std::min(streams, total));
+            detector = std::max(1, std::min(3, total / frame));
+            kernel = frame == 1 ? std::max(1, total - detector + 1) : 1;  // detector + kernel - 1 <= total
+        }
+        if (streams == 1)
+            frame = 1;  // The single stream pipeline processes one frame at a time
+        buildBlocks();
+    }
+
+    // Number of frame workers the caller actually starts (one thread per shard, --workers), which may
+    // differ from the frame level of the split. The kernel pool is cut back so that
+    // frame * detector + kernel - 1 still fits the total; call before apply()
+    void setFrameWorkers(int workers)
+    {
+        frame = std::max(1, workers);
+        kernel = std::max(1, std::min(kernel, total - frame * detector + 1));
+        buildBlocks();
+    }
+
+    // Process-wide settings, called once before any worker starts
+    void apply() const
+    {
+        omp_set_dynamic(0);             // Exactly the requested number of detector threads
+        omp_set_max_active_levels(1);   // No nested teams below the detector level
+        cv::setNumThreads(kernel);      // Threads of a single OpenCV call, never changed while frames run
+        processStartNs = clockNs(CLOCK_PROCESS_CPUTIME_ID);
+        wallStartNs = clockNs(CLOCK_MONOTONIC);
+    }
+
+    // Per-thread settings of frame worker `worker`, called first in the worker thread
+    void bindWorker(int worker) const
+    {
+        omp_set_num_threads(detector);
+        if (placement == PLACE_NONE || blocks.empty())
+            return;
+        const std::vector<int> &block = blocks[worker % blocks.size()];
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int c : block)
+            CPU_SET(c, &set);
+        if (pthread_setaffinity_np(pthread_self(), sizeof(set), &set) != 0)
+            std::cout << "[threads] unable to pin worker " << worker << std::endl;
+    }
+
+    int frameThreads() const { return frame; }
+    int detectorThreads() const { return detector; }
+    int kernelThreads() const { return kernel; }
+
+    void describe(std::ostream &os) const
+    {
+        static const char *const names[] = {"none", "compact", "numa"};
+        os << "Thread layout: " << total << " threads >= " << frame << " frame x " << detector << " detector + "
+           << kernel << " kernel - 1, placement " << names[placement];
+        if (placement == PLACE_NUMA)
+            os << " (" << nodeCount << " nodes)";
+        os << std::endl;
+        for (size_t w = 0; placement != PLACE_NONE && w < blocks.size(); ++w)
+        {
+            os << "  worker " << w << ": cores";
+            for (int c : blocks[w])
+                os << " " << c;
+            os << std::endl;
+        }
+    }
+
+    // Stage accounting, safe to call from any thread
+    void addWall(PipelineStage s, long long ns) { wallNs[s] += ns; }
+    void addCpu(PipelineStage s, long long ns) { cpuNs[s] += ns; }
+
+    static long long clockNs(clockid_t clock)
+    {
+        timespec ts;
+        clock_gettime(clock, &ts);
+        return (long long)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+    }
+
+    // Utilisation of a stage is the CPU time of the threads running it over the wall time of the
+    // stage times the threads it was given. The process line also covers the OpenCV kernel threads,
+    // which the per-stage clocks cannot see.
+    void report(std::ostream &os) const
+    {
+        static const char *const names[] = {"decode", "lane", "detect", "output"};
+        os << "Stage utilisation:" << std::endl;
+        for (int s = 0; s < STAGE_COUNT; ++s)
+        {
+            int threads = s == STAGE_DETECT ? detector : 1;
+            double wall = wallNs[s] / 1e9, cpu = cpuNs[s] / 1e9;
+            os << "  " << std::left << std::setw(7) << names[s] << std::right << std::fixed << std::setprecision(2)
+               << " wall " << std::setw(8) << wall << " s  cpu " << std::setw(8) << cpu << " s  threads " << threads
+               << "  utilisation " << std::setprecision(0) << std::setw(3) << (wall > 0 ? 100.0 * cpu / (wall * threads) : 0.0)
+               << "%" << std::endl;
+        }
+        double wall = (clockNs(CLOCK_MONOTONIC) - wallStartNs) / 1e9;
+        double cpu = (clockNs(CLOCK_PROCESS_CPUTIME_ID) - processStartNs) / 1e9;
+        os << std::setprecision(2) << "  process cpu " << cpu << " s over " << wall << " s on " << total
+           << " threads, utilisation " << std::setprecision(0) << (wall > 0 ? 100.0 * cpu / (wall * total) : 0.0)
+           << "%" << std::endl;
+    }
+
+private:
+    int total, frame, detector, kernel;    // Thread split, see above
+    Placement placement;                   // How workers are pinned
+    bool explicitSplit;                    // Split given on the command line
+    int nodeCount = 1;                     // NUMA nodes holding usable cores
+    std::vector<int> cpus;                 // Cores the process may use
+    std::vector<std::vector<int>> blocks;  // Cores of every frame worker
+    std::atomic<long long> wallNs[STAGE_COUNT], cpuNs[STAGE_COUNT];  // Per-stage time
+    mutable long long processStartNs = 0, wallStartNs = 0;           // Start of the run
+
+    // Parse a sysfs CPU list such as "0-7,16-23"
+    static std::vector<int> parseCpuList(const std::string &list)
+    {
+        std::vector<int> out;
+        std::stringstream ss(list);
+        std::string range;
+        while (std::getline(ss, range, ','))
+        {
+            int a = 0, b = 0;
+            int n = sscanf(range.c_str(), "%d-%d", &a, &b);
+            if (n == 1)
+                b = a;
+            for (int c = a; n >= 1 && c <= b; ++c)
+                out.push_back(c);
+        }
+        return out;
+    }
+
+    // Usable cores grouped by NUMA node, a single group without NUMA information
+    std::vector<std::vector<int>> nodeCpus() const
+    {
+        std::vector<std::vector<int>> nodes;
+        DIR *dir = opendir("/sys/devices/system/node");
+        while (dir)
+        {
+            dirent *e = readdir(dir);
+            if (!e)
+                break;
+            int id = 0;
+            if (sscanf(e->d_name, "node%d", &id) != 1)
+                continue;
+            std::ifstream in("/sys/devices/system/node/" + std::string(e->d_name) + "/cpulist");
+            std::string list;
+            std::getline(in, list);
+            std::vector<int> usable;
+            for (int c : parseCpuList(list))
+                if (std::find(cpus.begin(), cpus.end(), c) != cpus.end())
+                    usable.push_back(c);
+            if (!usable.empty())
+            {
+                if ((int)nodes.size() <= id)
+                    nodes.resize(id + 1);
+                nodes[id] = usable;
+            }
+        }
+        if (dir)
+            closedir(dir);
+        nodes.erase(std::remove_if(nodes.begin(), nodes.end(), [](const std::vector<int> &n) { return n.empty(); }), nodes.end());
+        if (nodes.empty())
+            nodes.push_back(cpus);
+        return nodes;
+    }
+
+    // Give every frame worker total / frame cores. Compact fills the cores in order, NUMA
+    // alternates the workers between the nodes and keeps each block inside its node.
+    void buildBlocks()
+    {
+        blocks.clear();
+        if (placement == PLACE_NONE)
+            return;
+        int per = std::max(1, total / frame);  // Cores of one worker
+        std::vector<std::vector<int>> nodes = placement == PLACE_NUMA ? nodeCpus() : std::vector<std::vector<int>>(1, cpus);
+        nodeCount = (int)nodes.size();
+        std::vector<size_t> next(nodes.size(), 0);  // Next unused core of every node
+        for (int w = 0; w < frame; ++w)
+        {
+            std::vector<int> &node = nodes[w % nodes.size()];
+            std::vector<int> block;
+            for (int k = 0; k < per; ++k)
+                block.push_back(node[next[w % nodes.size()]++ % node.size()]);  // Wraps when oversubscribed
+            blocks.push_back(block);
+        }
+    }
+};
+
+// Adds the wall and thread CPU time of its scope to a stage
+class StageClock
+{
+public:
+    StageClock(ThreadLayout &layout, PipelineStage stage)
+        : layout(layout), stage(stage), wall0(ThreadLayout::clockNs(CLOCK_MONOTONIC)),
+          cpu0(ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID)) {}
+
+    ~StageClock()
+    {
+        layout.addWall(stage, ThreadLayout::clockNs(CLOCK_MONOTONIC) - wall0);
+        layout.addCpu(stage, ThreadLayout::clockNs(CLOCK_THREAD_CPUTIME_ID) - cpu0);
+    }
+
+private:
+    ThreadLayout &layout;
+    PipelineStage stage;
+    long long wall0, cpu0;
+};
+
+#endif // THREAD_LAYOUT_HPP
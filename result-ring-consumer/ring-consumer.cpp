@@ -0,0 +1,103 @@
+#include <opencv2/core.hpp>      // Include for core functionalities and data structures
+#include <opencv2/highgui.hpp>   // Include for displaying the published frames
+#include <iostream>              // Include for standard input/output operations
+#include <thread>                // Include for sleeping while the ring is idle
+#include <chrono>                // Include for the poll interval
+#include <cstdlib>               // Include for parsing numeric arguments
+
+#include "result_ring.hpp"       // Shared memory result ring
+
+using namespace cv;   // OpenCV namespace for core OpenCV functions and types
+using namespace std;  // Standard namespace for standard functions and types
+
+// Print one record as CSV lines: one line per lane and per box
+static void printRecord(const ResultRecord &r)
+{
+    for (int i = 0; i < r.laneCount; ++i)
+        cout << r.frameIndex << "," << r.timestampNs << "," << r.mediaTimeMs << ",lane,"
+             << r.lanes[i][0] << "," << r.lanes[i][1] << "," << r.lanes[i][2] << "," << r.lanes[i][3] << ",,,\n";
+    for (int i = 0; i < r.boxCount; ++i)
+    {
+        const ResultBox &b = r.boxes[i];
+        cout << r.frameIndex << "," << r.timestampNs << "," << r.mediaTimeMs << "," << resultClassName(b.cls) << ","
+             << b.x << "," << b.y << "," << b.w << "," << b.h << "," << b.cx << "," << b.cy << "," << b.trackId << "\n";
+    }
+    if (r.laneCount == 0 && r.boxCount == 0)
+        cout << r.frameIndex << "," << r.timestampNs << "," << r.mediaTimeMs << ",none,,,,,,,\n";
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <ring-name> [--show] [--from-start] [--idle-exit <seconds>]" << endl;
+        return -1;
+    }
+
+    string name = argv[1];  // Name of the shared memory object, e.g. /adas
+    bool show = false;  // Display the published frames
+    bool fromStart = false;  // Start with the oldest record still in the ring instead of the newest
+    double idleExit = 0;  // Exit after this many seconds without new records, 0 waits forever
+    for (int i = 2; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--show") show = true;
+        else if (arg == "--from-start") fromStart = true;
+        else if (arg == "--idle-exit" && i + 1 < argc) idleExit = atof(argv[++i]);
+        else
+        {
+            cout << "Error: Unknown argument '" << arg << "'." << endl;
+            return -1;
+        }
+    }
+
+    ResultRingReader ring;  // Read-only mapping of the ring
+    while (!ring.open(name))  // The producer may not have started yet
+        this_thread::sleep_for(chrono::milliseconds(100));
+    cerr << "Attached to " << name << " (" << ring.capacity() << " slots" << (ring.hasFrames() ? ", with frames" : "") << ")" << endl;
+
+    uint64_t head = ring.head();  // Records published so far
+    uint64_t next = fromStart ? (head > ring.capacity() ? head - ring.capacity() : 0) : head;  // Next record to read
+    uint64_t lost = 0;  // Records overwritten before they were read
+    ResultRecord record;  // Copy of the current record
+    Mat frame;  // Copy of the current frame
+    auto lastRecord = chrono::steady_clock::now();
+
+    cout << "frame,timestamp_ns,media_ms,class,a,b,c,d,cx,cy,id" << endl;
+    while (true)
+    {
+        head = ring.head();
+        if (next >= head)
+        {
+            double idle = chrono::duration<double>(chrono::steady_clock::now() - lastRecord).count();
+            if (idleExit > 0 && idle > idleExit)
+                break;
+            this_thread::sleep_for(chrono::milliseconds(1));  // Nothing new, poll again shortly
+            continue;
+        }
+        if (head - next > ring.capacity())
+        {
+            lost += head - ring.capacity() - next;  // The producer lapped this consumer
+            next = head - ring.capacity();
+        }
+
+        ResultRingReader::Status status = ring.read(next, record, show ? &frame : nullptr);
+        if (status == ResultRingReader::READ_OK)
+        {
+            printRecord(record);
+            if (show && !frame.empty())
+            {
+                imshow("Published frames", frame);
+                if ((char)waitKey(1) == 'q')
+                    break;
+            }
+        }
+        else
+            lost++;  // Overwritten while reading
+        next++;
+        lastRecord = chrono::steady_clock::now();
+    }
+
+    cerr << "Read up to record " << next << ", lost " << lost << " records" << endl;
+    return 0;
+}
@@ -2,27 +2,73 @@
 #include <opencv2/imgproc.hpp>  // Include the header for image processing functions
 #include <iostream>             // Include the header for standard input/output stream objects
 
+#include "synthetic_scene.hpp"  // Procedural frame source for headless load testing
+#include "change_detector.hpp"  // Skips the skeletonization while the scene does not change
+
 using namespace cv;             // Use the OpenCV namespace for easier code writing
 using namespace std;            // Use the standard namespace for easier code writing
 
 // Main function
 int main(int argc, char** argv)
 {
-    VideoCapture cap(0); // Open the default camera (camera 0)
-    if (!cap.isOpened()) // Check if the camera is opened successfully
+    string syntheticSpec; // Resolution of the synthetic scene, empty to use the camera
+    bool headless = false; // Do not open any window
+    bool dump = false; // Write every skeleton to a PGM file even in headless mode
+    int maxFrames = 4000; // Number of frames to process
+    double skipThreshold = 0.0; // Block difference below which a frame reuses the previous skeleton, 0 disables
+    int maxSkip = 30; // Frames skipped in a row before one is processed anyway
+    for (int i = 1; i < argc; i++) // Parse the command-line arguments
     {
-        cerr << "Error: Unable to open camera!" << endl; // Print error message
+        string arg = argv[i];
+        if (arg == "--synthetic" && i + 1 < argc) syntheticSpec = argv[++i]; // Use the synthetic scene instead of the camera
+        else if (arg == "--frames" && i + 1 < argc) maxFrames = atoi(argv[++i]); // Stop after a number of frames
+        else if (arg == "--headless") headless = true; // Run without any window
+        else if (arg == "--dump") dump = true; // Keep writing the frames in headless mode
+        else if (arg == "--skip-static" && i + 1 < argc) skipThreshold = atof(argv[++i]); // Reuse the skeleton while the scene does not change
+        else if (arg == "--max-skip" && i + 1 < argc) maxSkip = atoi(argv[++i]); // Process at least every n-th frame
+        else
+        {
+            cerr << "Usage: " << argv[0] << " [--synthetic <W>x<H>[@fps]] [--frames <n>] [--headless [--dump]] [--skip-static <threshold> [--max-skip <n>]]" << endl; // Print usage
+            return -1; // Exit the program with an error code
+        }
+    }
+
+    Size syntheticSize; // Resolution of the synthetic scene
+    double syntheticFps = 30.0; // Frame rate of the synthetic scene
+    if (!syntheticSpec.empty() && !SyntheticScene::parseSpec(syntheticSpec, syntheticSize, syntheticFps))
+    {
+        cerr << "Error: Invalid synthetic resolution '" << syntheticSpec << "'!" << endl; // Print error message
         return -1; // Exit the program with an error code
     }
+    SyntheticScene scene(syntheticSize, syntheticFps); // Synthetic frame source, only used with --synthetic
+
+    VideoCapture cap; // Camera capture, only used without --synthetic
+    if (syntheticSpec.empty())
+    {
+        cap.open(0); // Open the default camera (camera 0)
+        if (!cap.isOpened()) // Check if the camera is opened successfully
+        {
+            cerr << "Error: Unable to open camera!" << endl; // Print error message
+            return -1; // Exit the program with an error code
+        }
+    }
 
     cout << "Press 'q' or <ESC> to quit." << endl; // Print message for quitting
+    dump = dump || !headless; // A headless load test measures the pipeline, not the disk
 
     Mat frame, gray, binary, mfblur; // Declare matrices to hold different stages of image processing
+    Mat skel; // Skeleton image, carried over to unchanged frames
+    int iterations = 0; // Iterations of the last skeletonization
+    ChangeDetector change(skipThreshold, maxSkip); // Front end deciding whether a frame has to be processed
     int frame_count = 1; // Initialize frame counter
+    int64 start = getTickCount(); // Start time for the throughput report
 
     while (true) // Infinite loop to process each frame
     {
-        cap >> frame; // Capture a frame from the camera
+        if (syntheticSpec.empty())
+            cap >> frame; // Capture a frame from the camera
+        else
+            scene >> frame; // Render a synthetic frame
 
         if (frame.empty()) // Check if the frame is empty
         {
@@ -30,46 +76,55 @@ int main(int argc, char** argv)
             break; // Exit the loop
         }
 
-        cvtColor(frame, gray, COLOR_BGR2GRAY); // Convert the captured frame to grayscale
-
-        threshold(gray, binary, 50, 255, THRESH_BINARY); // Apply binary thresholding
-        binary = 255 - binary; // Invert the binary image
-
-        // To remove median filter, just replace blur value with 1
-        medianBlur(binary, mfblur, 1); // Apply median blur to the binary image
-
-        Mat skel(mfblur.size(), CV_8UC1, Scalar(0)); // Initialize the skeleton image
-        Mat temp; // Temporary matrix for intermediate results
-        Mat eroded; // Matrix to hold the eroded image
-        Mat element = getStructuringElement(MORPH_CROSS, Size(5, 5)); // Structuring element for morphological operations
-        bool done; // Flag to indicate if skeletonization is complete
-        int iterations = 0; // Counter for the number of iterations
+        if (change.changed(frame)) // Static frames re-emit the skeleton of the last processed frame
+        {
+            cvtColor(frame, gray, COLOR_BGR2GRAY); // Convert the captured frame to grayscale
+
+            threshold(gray, binary, 50, 255, THRESH_BINARY); // Apply binary thresholding
+            binary = 255 - binary; // Invert the binary image
+
+            // To remove median filter, just replace blur value with 1
+            medianBlur(binary, mfblur, 1); // Apply median blur to the binary image
+
+            skel = Mat(mfblur.size(), CV_8UC1, Scalar(0)); // Initialize the skeleton image
+            Mat temp; // Temporary matrix for intermediate results
+            Mat eroded; // Matrix to hold the eroded image
+            Mat element = getStructuringElement(MORPH_CROSS, Size(5, 5)); // Structuring element for morphological operations
+            bool done; // Flag to indicate if skeletonization is complete
+            iterations = 0; // Counter for the number of iterations
+
+            do
+            {
+                erode(mfblur, eroded, element); // Erode the image
+                dilate(eroded, temp, element); // Dilate the eroded image
+                subtract(mfblur, temp, temp); // Subtract the dilated image from the original image
+                bitwise_or(skel, temp, skel); // Combine the result with the skeleton image
+                eroded.copyTo(mfblur); // Copy the eroded image back to the original image
+
+                done = (countNonZero(mfblur) == 0); // Check if there are no non-zero pixels left
+                iterations++; // Increment the iteration counter
+            } while (!done && (iterations < 100)); // Continue until skeletonization is complete or maximum iterations reached
+        }
 
-        do
+        if (dump)
         {
-            erode(mfblur, eroded, element); // Erode the image
-            dilate(eroded, temp, element); // Dilate the eroded image
-            subtract(mfblur, temp, temp); // Subtract the dilated image from the original image
-            bitwise_or(skel, temp, skel); // Combine the result with the skeleton image
-            eroded.copyTo(mfblur); // Copy the eroded image back to the original image
+            string filename = "frame" + to_string(frame_count) + ".pgm"; // Generate the filename for saving the frame
+            imwrite(filename, skel); // Save the skeleton image
+        }
+        frame_count++; // Increment the frame counter
+        if(frame_count > maxFrames) // If the frame counter exceeds the frame limit (4000 by default), exit the loop
+        {
+            break; // Exit the loop
+        }
 
-            done = (countNonZero(mfblur) == 0); // Check if there are no non-zero pixels left
-            iterations++; // Increment the iteration counter
-        } while (!done && (iterations < 100)); // Continue until skeletonization is complete or maximum iterations reached
+        if (headless) // No window and no per-frame output in headless mode
+            continue;
 
         cout << "iterations=" << iterations << endl; // Print the number of iterations
 
         imshow("source", frame); // Display the original frame
         imshow("skeleton", skel); // Display the skeleton image
 
-        string filename = "frame" + to_string(frame_count) + ".pgm"; // Generate the filename for saving the frame
-        imwrite(filename, skel); // Save the skeleton image
-        frame_count++; // Increment the frame counter
-        if(frame_count > 4000) // If the frame counter exceeds 4000, exit the loop
-        {
-            break; // Exit the loop
-        }
-
         char key = waitKey(30); // Wait for 30 milliseconds for a key press
         if (key == 27 || key == 'q') // If the 'ESC' or 'q' key is pressed
         {
@@ -78,6 +133,11 @@ int main(int argc, char** argv)
         }
     }
 
+    double seconds = (getTickCount() - start) / getTickFrequency(); // Total processing time
+    cout << "Processed " << frame_count - 1 << " frames, " << (seconds > 0 ? (frame_count - 1) / seconds : 0.0) << " frames/second" << endl;
+    if (change.enabled())
+        cout << "Change detector: " << change.skippedCount() << " static frames skipped" << endl;
+
     cap.release();          // Release the camera
     destroyAllWindows();   // Close all OpenCV windows
     return 0; // Return success code
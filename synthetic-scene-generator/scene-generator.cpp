@@ -0,0 +1,181 @@
+#include <opencv2/core.hpp>      // Include for core functionalities and data structures
+#include <opencv2/imgproc.hpp>   // Include for Canny, HoughLinesP and HoughCircles
+#include <opencv2/videoio.hpp>   // Include for writing the rendered clip
+#include <iostream>              // Include for standard input/output operations
+#include <fstream>               // Include for writing the ground truth file
+#include <iomanip>               // Include for formatting the benchmark report
+#include <cmath>                 // Include for distance computations
+#include <cstdlib>               // Include for parsing numeric arguments
+
+#include "synthetic_scene.hpp"   // Procedural frame source with ground truth
+#include "lane_scoring.hpp"      // Lane scoring shared with auto-tuner
+
+using namespace cv;   // OpenCV namespace for core OpenCV functions and types
+using namespace std;  // Standard namespace for standard functions and types
+
+// Accuracy and time counters for one benchmarked stage
+struct StageStats
+{
+    double seconds = 0;  // Total time spent in the stage
+    int truePositives = 0;  // Detections that matched a ground truth object
+    int found = 0;  // Ground truth objects matched by at least one detection
+    int detections = 0;  // All detections produced by the stage
+    int expected = 0;  // All ground truth objects the stage should have found
+};
+
+// Print one line of the benchmark report
+static void report(const string &name, const StageStats &s, int frames)
+{
+    double precision = s.detections ? (double)s.truePositives / s.detections : 0.0;  // Fraction of correct detections
+    double recall = s.expected ? (double)s.found / s.expected : 0.0;  // Fraction of found objects
+    cout << left << setw(8) << name << fixed << setprecision(1)
+         << " fps: " << setw(8) << (s.seconds > 0 ? frames / s.seconds : 0.0)
+         << " ms/frame: " << setw(7) << setprecision(2) << (frames ? 1000.0 * s.seconds / frames : 0.0)
+         << " precision: " << setprecision(3) << precision
+         << " recall: " << recall << endl;
+}
+
+// Run the Hough line stage used by hough-line-detection and count segments lying on a lane
+static void benchLines(const Mat &frame, const vector<SceneObject> &truth, StageStats &s)
+{
+    Mat edges;  // Canny edges of the frame
+    vector<Vec4i> lines;  // Detected line segments
+    int64 t = getTickCount();
+    Canny(frame, edges, 50, 200, 3);
+    HoughLinesP(edges, lines, 1, CV_PI / 360, 50, 5, 2);
+    s.seconds += (getTickCount() - t) / getTickFrequency();
+
+    vector<Vec4f> lanes;  // Lane axes of the frame
+    for (const SceneObject &o : truth)
+        if (o.label == "lane")
+            lanes.push_back(o.value);
+    LaneScore score = scoreLaneSegments(lines, lanes, laneTolerance(frame.rows));  // Same scoring as auto-tuner
+    s.truePositives += score.truePositives;
+    s.detections += score.detections;
+    s.found += score.found;
+    s.expected += score.expected;
+}
+
+// Run the Hough circle stage used by hough-circle-detection and match circles by centre and radius
+static void benchCircles(const Mat &frame, const vector<SceneObject> &truth, StageStats &s)
+{
+    Mat gray;  // Blurred grayscale frame
+    vector<Vec3f> circles;  // Detected circles
+    int64 t = getTickCount();
+    cvtColor(frame, gray, COLOR_BGR2GRAY);
+    GaussianBlur(gray, gray, Size(9, 9), 2, 2);
+    HoughCircles(gray, circles, HOUGH_GRADIENT, 1, gray.rows / 8, 100, 50, 0, 0);
+    s.seconds += (getTickCount() - t) / getTickFrequency();
+
+    s.detections += (int)circles.size();
+    for (const SceneObject &o : truth)
+    {
+        if (o.label != "circle")
+            continue;
+        s.expected++;
+        for (const Vec3f &c : circles)
+        {
+            double centerError = norm(Point2f(c[0], c[1]) - Point2f(o.value[0], o.value[1]));
+            double radiusError = fabs(c[2] - o.value[2]);
+            if (centerError < 0.2 * o.value[2] && radiusError < 0.2 * o.value[2])
+            {
+                s.truePositives++;  // Each ground truth circle is matched at most once
+                s.found++;
+                break;
+            }
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        cout << "Usage: " << argv[0] << " <W>x<H>[@fps]|480p|720p|1080p|4k|8k [--frames <n>] [--edge-density <d>]"
+             << " [--seed <s>] [--store <output>.avi] [--truth <truth>.csv] [--bench]" << endl;
+        return -1;
+    }
+
+    Size size;  // Output resolution
+    double fps = 30.0;  // Output frame rate
+    if (!SyntheticScene::parseSpec(argv[1], size, fps))
+    {
+        cout << "Error: Invalid resolution '" << argv[1] << "'." << endl;
+        return -1;
+    }
+
+    int frames = 300;  // Number of frames to render
+    double edgeDensity = 0.2;  // Background clutter density
+    uint64_t seed = 1;  // Seed of the scene
+    string storeFile, truthFile;  // Optional outputs
+    bool bench = false;  // Run the Hough stages on every frame and report throughput and accuracy
+    for (int i = 2; i < argc; ++i)
+    {
+        string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) frames = atoi(argv[++i]);
+        else if (arg == "--edge-density" && i + 1 < argc) edgeDensity = atof(argv[++i]);
+        else if (arg == "--seed" && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--store" && i + 1 < argc) storeFile = argv[++i];
+        else if (arg == "--truth" && i + 1 < argc) truthFile = argv[++i];
+        else if (arg == "--bench") bench = true;
+        else
+        {
+            cout << "Error: Unknown argument '" << arg << "'." << endl;
+            return -1;
+        }
+    }
+
+    SyntheticScene scene(size, fps, edgeDensity, seed);  // Frame source
+    scene.setFrameLimit(frames);
+
+    VideoWriter outputVideo;  // Optional clip writer
+    if (!storeFile.empty() && !outputVideo.open(storeFile, VideoWriter::fourcc('M', 'J', 'P', 'G'), fps, size, true))
+    {
+        cout << "Error: Unable to open output file." << endl;
+        return -1;
+    }
+
+    ofstream truthOut;  // Optional ground truth writer
+    if (!truthFile.empty())
+    {
+        truthOut.open(truthFile);
+        if (!truthOut)
+        {
+            cout << "Error: Unable to open ground truth file." << endl;
+            return -1;
+        }
+        truthOut << "frame,class,a,b,c,d\n";  // Header, see SceneObject for the meaning of a..d
+    }
+
+    StageStats render, lines, circles;  // Per stage counters
+    Mat frame;  // Current rendered frame
+    int rendered = 0;
+    while (true)
+    {
+        int64 t = getTickCount();
+        if (!scene.read(frame))
+            break;
+        render.seconds += (getTickCount() - t) / getTickFrequency();
+        rendered++;
+
+        if (outputVideo.isOpened())
+            outputVideo.write(frame);
+        if (truthOut.is_open())
+            scene.writeTruthCsv(truthOut);
+        if (bench)
+        {
+            benchLines(frame, scene.truth(), lines);
+            benchCircles(frame, scene.truth(), circles);
+        }
+    }
+
+    cout << "Rendered " << rendered << " frames at " << size.width << "x" << size.height
+         << " (edge density " << edgeDensity << ")" << endl;
+    report("render", render, rendered);
+    if (bench)
+    {
+        report("lines", lines, rendered);
+        report("circles", circles, rendered);
+    }
+    return 0;
+}